@@ -0,0 +1,209 @@
+/*
+ * Standalone timings of the date arithmetic kernels (no R required).
+ *
+ * Build and run from the package root with, e.g.
+ *
+ *     cc -O2 -Isrc inst/bench/kernels.c src/days_from_civil.c \
+ *         src/civil_from_days.c src/epochdays.c -o kernels
+ *     ./kernels 1000 1000000 100000000 > kernels.csv
+ *
+ * Each argument is an input size (default 1e3 to 1e8 by powers of 10). For
+ * each kernel, size and input range the best of several repetitions is
+ * written to stdout as CSV along with a checksum of the output so that runs
+ * (and kernels computing the same thing) can be compared.
+ */
+
+#include "civil_from_days.h"
+#include "days_from_civil.h"
+#include "epochdays.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define REPS 5
+#define BLOCK 1024
+
+struct range {
+	const char *name;
+	int min_year;
+	int max_year;
+	int sorted;
+};
+
+/*
+ * The table window and a wider range still valid for jsondec_epochdays(),
+ * plus a daily sequence from the start of the wider range.
+ */
+static const struct range ranges[] = {
+	{"window", 1900, 2100, 0},
+	{"wide", -4000, 9999, 0},
+	{"daily", -4000, 9999, 1},
+};
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* xorshift so inputs are reproducible across platforms */
+static uint64_t state = 88172645463325252ULL;
+static uint32_t next(void)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return (uint32_t) (state >> 32);
+}
+
+static int *y, *m, *d, *z, *out_y, *out_m, *out_d;
+
+static void fill(ptrdiff_t n, struct range r)
+{
+	const int first = days_from_civil(r.min_year, 1, 1);
+	for (ptrdiff_t i = 0; i < n; i++) {
+		if (r.sorted) {
+			z[i] = first + (int) i;
+			civil_from_days(z[i], &y[i], &m[i], &d[i]);
+			continue;
+		}
+		y[i] = r.min_year + (int) (next() % (uint32_t) (r.max_year - r.min_year + 1));
+		m[i] = 1 + (int) (next() % 12);
+		d[i] = 1 + (int) (next() % 28);
+		z[i] = days_from_civil(y[i], m[i], d[i]);
+	}
+}
+
+static uint64_t checksum(const int *x, ptrdiff_t n)
+{
+	uint64_t h = 1469598103934665603ULL;
+	for (ptrdiff_t i = 0; i < n; i++)
+		h = (h ^ (uint32_t) x[i]) * 1099511628211ULL;
+	return h;
+}
+
+/* kernels: each fills the output vector(s) from the inputs */
+
+static void k_days_from_civil(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		out_y[i] = days_from_civil(y[i], m[i], d[i]);
+}
+
+static void k_days_from_civil_fast(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		out_y[i] = days_from_civil_fast(y[i], m[i], d[i]);
+}
+
+static void k_days_from_civil_neri(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		out_y[i] = days_from_civil_neri(y[i], m[i], d[i]);
+}
+
+static void k_jsondec_epochdays(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		out_y[i] = jsondec_epochdays(y[i], m[i], d[i]);
+}
+
+static void k_civil_from_days(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		civil_from_days(z[i], &out_y[i], &out_m[i], &out_d[i]);
+}
+
+static void k_civil_from_days_n(ptrdiff_t n)
+{
+	for (ptrdiff_t from = 0; from < n; from += BLOCK) {
+		ptrdiff_t len = n - from < BLOCK ? n - from : BLOCK;
+		civil_from_days_n(z + from, len, out_y + from, out_m + from, out_d + from);
+	}
+}
+
+static void k_civil_from_days_sorted_n(ptrdiff_t n)
+{
+	for (ptrdiff_t from = 0; from < n; from += BLOCK) {
+		ptrdiff_t len = n - from < BLOCK ? n - from : BLOCK;
+		civil_from_days_sorted_n(z + from, len, out_y + from, out_m + from, out_d + from);
+	}
+}
+
+static void k_year_from_days(ptrdiff_t n)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		out_y[i] = year_from_days(z[i]);
+}
+
+static const struct {
+	const char *name;
+	void (*run)(ptrdiff_t);
+	int **result;
+} kernels[] = {
+	{"days_from_civil", k_days_from_civil, &out_y},
+	{"days_from_civil_fast", k_days_from_civil_fast, &out_y},
+	{"days_from_civil_neri", k_days_from_civil_neri, &out_y},
+	{"jsondec_epochdays", k_jsondec_epochdays, &out_y},
+	{"civil_from_days", k_civil_from_days, &out_d},
+	{"civil_from_days_n", k_civil_from_days_n, &out_d},
+	{"civil_from_days_sorted_n", k_civil_from_days_sorted_n, &out_d},
+	{"year_from_days", k_year_from_days, &out_y},
+};
+
+int main(int argc, char **argv)
+{
+	ptrdiff_t sizes[16];
+	int nsizes = 0;
+	if (argc > 1) {
+		for (int i = 1; i < argc && nsizes < 16; i++)
+			sizes[nsizes++] = (ptrdiff_t) strtod(argv[i], NULL);
+	} else {
+		for (ptrdiff_t s = 1000; s <= 100000000; s *= 10)
+			sizes[nsizes++] = s;
+	}
+
+	ptrdiff_t max = 0;
+	for (int i = 0; i < nsizes; i++)
+		max = sizes[i] > max ? sizes[i] : max;
+
+	int **vecs[] = {&y, &m, &d, &z, &out_y, &out_m, &out_d};
+	for (size_t i = 0; i < sizeof(vecs) / sizeof(vecs[0]); i++) {
+		*vecs[i] = malloc((max > 0 ? max : 1) * sizeof(int));
+		if (*vecs[i] == NULL) {
+			fprintf(stderr, "unable to allocate %td elements\n", max);
+			return 1;
+		}
+	}
+
+	init_civil_from_days_table();
+	init_days_from_civil_table();
+
+	printf("kernel,range,n,seconds,ns_per_element,checksum\n");
+	for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+		for (int s = 0; s < nsizes; s++) {
+			ptrdiff_t n = sizes[s];
+			fill(n, ranges[r]);
+			for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+				double best = -1;
+				for (int rep = 0; rep < REPS; rep++) {
+					double start = now();
+					kernels[k].run(n);
+					double elapsed = now() - start;
+					best = best < 0 || elapsed < best ? elapsed : best;
+				}
+				printf("%s,%s,%td,%.9f,%.3f,%016llx\n",
+					kernels[k].name, ranges[r].name, n, best,
+					n ? best * 1e9 / n : 0.0,
+					(unsigned long long) checksum(*kernels[k].result, n));
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sizeof(vecs) / sizeof(vecs[0]); i++)
+		free(*vecs[i]);
+	return 0;
+}
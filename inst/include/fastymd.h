@@ -0,0 +1,92 @@
+/*
+ * C API of fastymd for use in the compiled code of other packages.
+ *
+ * Add fastymd to both the LinkingTo and Imports fields of your DESCRIPTION
+ * (so the package is loaded before any of these are called) and include this
+ * header. Each function looks up the routine registered by fastymd on first
+ * use and then calls it directly, so no R objects are created.
+ *
+ * Day numbers are days since the UNIX epoch (1970-01-01) as used by `Date`.
+ * Missing and invalid values are NA_INTEGER.
+ */
+
+#ifndef FASTYMD_H
+#define FASTYMD_H
+
+#include <stddef.h>
+
+#include <R_ext/Rdynload.h>
+
+/* statuses returned by fastymd_parse_ymd() */
+#define FASTYMD_PARSE_OK         0 /* success */
+#define FASTYMD_PARSE_YEAR_RANGE 1 /* year outside [-9999, 9999] (set in *days) */
+#define FASTYMD_PARSE_BAD_YEAR   2 /* no year */
+#define FASTYMD_PARSE_BAD_MONTH  3 /* missing or invalid month */
+#define FASTYMD_PARSE_BAD_DAY    4 /* missing or invalid day for the month */
+#define FASTYMD_PARSE_TRAILING   5 /* (strict only) content after the date */
+
+/*
+ * Day number of a year, month and day. NA_INTEGER if any component is
+ * missing, the date is invalid or the year is outside [-9999, 9999].
+ */
+static inline int fastymd_days_from_civil(int year, int month, int day)
+{
+	static int (*fun)(int, int, int) = NULL;
+	if (fun == NULL)
+		fun = (int (*)(int, int, int)) R_GetCCallable("fastymd", "days_from_civil");
+	return fun(year, month, day);
+}
+
+/* Year, month and day of a day number (all NA_INTEGER for NA_INTEGER). */
+static inline void fastymd_civil_from_days(int days, int *year, int *month, int *day)
+{
+	static void (*fun)(int, int *, int *, int *) = NULL;
+	if (fun == NULL)
+		fun = (void (*)(int, int *, int *, int *)) R_GetCCallable("fastymd", "civil_from_days");
+	fun(days, year, month, day);
+}
+
+/*
+ * Parse the year-month-day string of `len` bytes at `x` (not necessarily
+ * nul terminated) with the rules of fymd(). Returns one of the statuses above
+ * and, on success, sets *days. If `strict` is non-zero anything other than
+ * whitespace after the date is an error.
+ */
+static inline int fastymd_parse_ymd(const char *x, size_t len, int strict, int *days)
+{
+	static int (*fun)(const char *, size_t, int, int *) = NULL;
+	if (fun == NULL)
+		fun = (int (*)(const char *, size_t, int, int *)) R_GetCCallable("fastymd", "parse_ymd");
+	return fun(x, len, strict, days);
+}
+
+/* fastymd_days_from_civil() for n elements. */
+static inline void fastymd_days_from_civil_n(const int *year, const int *month, const int *day, ptrdiff_t n, int *days)
+{
+	static void (*fun)(const int *, const int *, const int *, ptrdiff_t, int *) = NULL;
+	if (fun == NULL)
+		fun = (void (*)(const int *, const int *, const int *, ptrdiff_t, int *)) R_GetCCallable("fastymd", "days_from_civil_n");
+	fun(year, month, day, n, days);
+}
+
+/*
+ * fastymd_civil_from_days() for n elements. The sorted variant is faster
+ * for days that are increasing in small steps (and correct for any input).
+ */
+static inline void fastymd_civil_from_days_n(const int *days, ptrdiff_t n, int *year, int *month, int *day)
+{
+	static void (*fun)(const int *, ptrdiff_t, int *, int *, int *) = NULL;
+	if (fun == NULL)
+		fun = (void (*)(const int *, ptrdiff_t, int *, int *, int *)) R_GetCCallable("fastymd", "civil_from_days_n");
+	fun(days, n, year, month, day);
+}
+
+static inline void fastymd_civil_from_days_sorted_n(const int *days, ptrdiff_t n, int *year, int *month, int *day)
+{
+	static void (*fun)(const int *, ptrdiff_t, int *, int *, int *) = NULL;
+	if (fun == NULL)
+		fun = (void (*)(const int *, ptrdiff_t, int *, int *, int *)) R_GetCCallable("fastymd", "civil_from_days_sorted_n");
+	fun(days, n, year, month, day);
+}
+
+#endif
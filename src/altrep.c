@@ -0,0 +1,299 @@
+#include "altrep.h"
+#include "civil_from_days.h"
+
+#include <limits.h>
+
+#include <R_ext/Altrep.h>
+
+/*
+ * Lazy year, month and month-day vectors.
+ *
+ * These are ALTREP integer vectors wrapping the source Date vector (data1).
+ * Elements are calculated on access and the full vector is only materialized
+ * when something asks for a pointer to the data. For sorted inputs the year
+ * vector can also report its sortedness, minimum and maximum from the ends of
+ * the source rather than by calculating every year. Whether the source is
+ * sorted is taken from R when known and otherwise found by a scan of the days
+ * that stops at the first out of order pair. The answer is cached so the scan
+ * is done at most once per vector.
+ *
+ * data2 is a list holding the materialized vector and the cached sortedness,
+ * each NULL until known.
+ */
+
+enum lazy_slot { LAZY_DATA, LAZY_SORTED, N_LAZY_SLOTS };
+
+static R_altrep_class_t year_class;
+static R_altrep_class_t month_class;
+static R_altrep_class_t mday_class;
+
+/* day number of element i of the source vector (double values are floored) */
+static inline int source_days(SEXP src, R_xlen_t i)
+{
+	if (TYPEOF(src) == INTSXP)
+		return INTEGER_ELT(src, i);
+
+	/* match the NA handling of Rf_coerceVector() */
+	double value = REAL_ELT(src, i);
+	if (ISNAN(value) || value >= INT_MAX + 1. || value <= INT_MIN)
+		return NA_INTEGER;
+	return (int) floor(value);
+}
+
+/*
+ * Direction of n (> 0) days found by a scan that stops at the first pair in
+ * neither order. Missing values are reported as unknown.
+ */
+#define DEFINE_PROBE(name, type, isna)                                       \
+	static int name(const type *p, R_xlen_t n)                               \
+	{                                                                        \
+		bool incr = true, decr = true;                                       \
+		if (isna(p[0]))                                                      \
+			return UNKNOWN_SORTEDNESS;                                       \
+		for (R_xlen_t i = 1; i < n && (incr || decr); i++) {                 \
+			if (isna(p[i]))                                                  \
+				return UNKNOWN_SORTEDNESS;                                   \
+			incr &= p[i] >= p[i - 1];                                        \
+			decr &= p[i] <= p[i - 1];                                        \
+		}                                                                    \
+		return incr ? SORTED_INCR : decr ? SORTED_DECR : UNKNOWN_SORTEDNESS; \
+	}
+
+#define INT_ISNA(v) ((v) == NA_INTEGER)
+DEFINE_PROBE(probe_int, int, INT_ISNA)
+DEFINE_PROBE(probe_real, double, ISNAN)
+
+/*
+ * Sortedness of a source vector with no missing values and only elements
+ * that map to a valid day. Anything else is reported as unknown. R only
+ * knows the sortedness of some (ALTREP) vectors so others are scanned, as
+ * long as their data is available without allocating.
+ */
+static int source_sortedness(SEXP src)
+{
+	R_xlen_t n = XLENGTH(src);
+	if (n == 0)
+		return UNKNOWN_SORTEDNESS;
+
+	int sorted;
+	bool no_na;
+	if (TYPEOF(src) == INTSXP) {
+		sorted = INTEGER_IS_SORTED(src);
+		no_na = INTEGER_NO_NA(src);
+	} else {
+		sorted = REAL_IS_SORTED(src);
+		no_na = REAL_NO_NA(src);
+	}
+
+	if (!no_na || (sorted != SORTED_INCR && sorted != SORTED_DECR)) {
+		const void *data = DATAPTR_OR_NULL(src);
+		if (data == NULL)
+			return UNKNOWN_SORTEDNESS;
+		sorted = TYPEOF(src) == INTSXP ? probe_int(data, n) : probe_real(data, n);
+		if (sorted == UNKNOWN_SORTEDNESS)
+			return UNKNOWN_SORTEDNESS;
+	}
+
+	/* values are monotone so checking the ends covers infinite values */
+	if (source_days(src, 0) == NA_INTEGER || source_days(src, n - 1) == NA_INTEGER)
+		return UNKNOWN_SORTEDNESS;
+
+	return sorted;
+}
+
+static inline SEXP lazy_state(SEXP x, enum lazy_slot slot)
+{
+	return VECTOR_ELT(R_altrep_data2(x), slot);
+}
+
+static int cached_sortedness(SEXP x)
+{
+	SEXP sorted = lazy_state(x, LAZY_SORTED);
+	if (sorted == R_NilValue) {
+		sorted = Rf_ScalarInteger(source_sortedness(R_altrep_data1(x)));
+		SET_VECTOR_ELT(R_altrep_data2(x), LAZY_SORTED, sorted);
+	}
+	return INTEGER(sorted)[0];
+}
+
+static int component_from_days(int value, enum component which)
+{
+	if (value == NA_INTEGER)
+		return NA_INTEGER;
+
+	switch (which) {
+	case COMPONENT_YEAR:
+		return year_from_days(value);
+	case COMPONENT_MONTH:
+		return month_from_days(value);
+	default:
+		return day_from_days(value);
+	}
+}
+
+static enum component component_of(SEXP x)
+{
+	if (R_altrep_inherits(x, year_class))
+		return COMPONENT_YEAR;
+	if (R_altrep_inherits(x, month_class))
+		return COMPONENT_MONTH;
+	return COMPONENT_MDAY;
+}
+
+/*
+ * Fill buf with elements [from, from + n) of the component. Returns true if
+ * any (non-NaN) double was outside the integer range.
+ */
+static bool fill_region(SEXP src, enum component which, R_xlen_t from, R_xlen_t n, int *buf)
+{
+	bool coerce = false;
+	for (R_xlen_t i = 0; i < n; i++) {
+		int days = source_days(src, from + i);
+		if (days == NA_INTEGER && TYPEOF(src) == REALSXP && !ISNAN(REAL_ELT(src, from + i)))
+			coerce = true;
+		buf[i] = component_from_days(days, which);
+	}
+	return coerce;
+}
+
+static SEXP materialize(SEXP x)
+{
+	SEXP out = lazy_state(x, LAZY_DATA);
+	if (out != R_NilValue)
+		return out;
+
+	SEXP src = R_altrep_data1(x);
+	R_xlen_t n = XLENGTH(src);
+	out = PROTECT(Rf_allocVector(INTSXP, n));
+	bool coerce = fill_region(src, component_of(x), 0, n, INTEGER(out));
+	SET_VECTOR_ELT(R_altrep_data2(x), LAZY_DATA, out);
+
+	/* as the eager accessors do */
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	UNPROTECT(1);
+	return out;
+}
+
+/* ALTREP methods */
+
+static R_xlen_t lazy_length(SEXP x)
+{
+	return XLENGTH(R_altrep_data1(x));
+}
+
+static void* lazy_dataptr(SEXP x, Rboolean writeable)
+{
+	(void) writeable;
+	return DATAPTR(materialize(x));
+}
+
+static const void* lazy_dataptr_or_null(SEXP x)
+{
+	SEXP data = lazy_state(x, LAZY_DATA);
+	return data == R_NilValue ? NULL : DATAPTR_RO(data);
+}
+
+static int lazy_elt(SEXP x, R_xlen_t i)
+{
+	SEXP data = lazy_state(x, LAZY_DATA);
+	if (data != R_NilValue)
+		return INTEGER(data)[i];
+	return component_from_days(source_days(R_altrep_data1(x), i), component_of(x));
+}
+
+static R_xlen_t lazy_get_region(SEXP x, R_xlen_t from, R_xlen_t n, int *buf)
+{
+	SEXP data = lazy_state(x, LAZY_DATA);
+	if (data != R_NilValue)
+		return INTEGER_GET_REGION(data, from, n, buf);
+
+	R_xlen_t size = lazy_length(x) - from;
+	if (n > size)
+		n = size;
+	fill_region(R_altrep_data1(x), component_of(x), from, n, buf);
+	return n;
+}
+
+static int lazy_no_na(SEXP x)
+{
+	SEXP src = R_altrep_data1(x);
+	return TYPEOF(src) == INTSXP ? INTEGER_NO_NA(src) : 0;
+}
+
+/* years of a sorted Date vector are sorted in the same direction */
+static int year_is_sorted(SEXP x)
+{
+	return cached_sortedness(x);
+}
+
+static SEXP year_extreme(SEXP x, bool max)
+{
+	SEXP src = R_altrep_data1(x);
+	int sorted = cached_sortedness(x);
+	if (sorted == UNKNOWN_SORTEDNESS)
+		return NULL;
+
+	R_xlen_t i = (max == (sorted == SORTED_INCR)) ? XLENGTH(src) - 1 : 0;
+	return Rf_ScalarInteger(year_from_days(source_days(src, i)));
+}
+
+static SEXP year_min(SEXP x, Rboolean narm)
+{
+	(void) narm;
+	return year_extreme(x, false);
+}
+
+static SEXP year_max(SEXP x, Rboolean narm)
+{
+	(void) narm;
+	return year_extreme(x, true);
+}
+
+static R_altrep_class_t make_class(const char *name, DllInfo *dll)
+{
+	R_altrep_class_t class = R_make_altinteger_class(name, "fastymd", dll);
+	R_set_altrep_Length_method(class, lazy_length);
+	R_set_altvec_Dataptr_method(class, lazy_dataptr);
+	R_set_altvec_Dataptr_or_null_method(class, lazy_dataptr_or_null);
+	R_set_altinteger_Elt_method(class, lazy_elt);
+	R_set_altinteger_Get_region_method(class, lazy_get_region);
+	R_set_altinteger_No_NA_method(class, lazy_no_na);
+	return class;
+}
+
+void init_lazy_components(DllInfo *dll)
+{
+	year_class = make_class("fastymd_year", dll);
+	R_set_altinteger_Is_sorted_method(year_class, year_is_sorted);
+	R_set_altinteger_Min_method(year_class, year_min);
+	R_set_altinteger_Max_method(year_class, year_max);
+
+	month_class = make_class("fastymd_month", dll);
+	mday_class = make_class("fastymd_mday", dll);
+}
+
+bool use_lazy_components(void)
+{
+	return Rf_asLogical(Rf_GetOption1(Rf_install("fastymd.lazy"))) == TRUE;
+}
+
+SEXP lazy_component(SEXP x, enum component which)
+{
+	R_altrep_class_t class;
+	switch (which) {
+	case COMPONENT_YEAR:
+		class = year_class;
+		break;
+	case COMPONENT_MONTH:
+		class = month_class;
+		break;
+	default:
+		class = mday_class;
+	}
+	SEXP state = PROTECT(Rf_allocVector(VECSXP, N_LAZY_SLOTS));
+	SEXP out = R_new_altrep(class, x, state);
+	UNPROTECT(1);
+	return out;
+}
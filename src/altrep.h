@@ -0,0 +1,17 @@
+#ifndef FASTYMD_ALTREP_H
+#define FASTYMD_ALTREP_H
+
+#include <stdbool.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <R_ext/Rdynload.h>
+
+enum component { COMPONENT_YEAR, COMPONENT_MONTH, COMPONENT_MDAY };
+
+void init_lazy_components(DllInfo *dll);
+bool use_lazy_components(void);
+SEXP lazy_component(SEXP x, enum component which);
+
+#endif
@@ -1,218 +1,733 @@
+#include "altrep.h"
+#include "calendar.h"
 #include "civil_from_days.h"
-#include "days_from_civil.h"
+#include "days.h"
+#include "diagnostics.h"
+#include "kernel.h"
+#include "parse.h"
+#include "threads.h"
 
+#include <limits.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <string.h>
 
 #define R_NO_REMAP
 #include <R.h>
 #include <Rinternals.h>
 
-/* From musl. */
-/* More efficient than using the functions for out purposes. */
-/* https://git.musl-libc.org/cgit/musl/tree/src/ctype/isdigit.c */
-/* https://git.musl-libc.org/cgit/musl/tree/src/ctype/isspace.c */
-#define ISDIGIT(c) ((unsigned)(c)-'0' < 10)
-#define ISSPACE(c) ((c) == ' ' || (unsigned)(c)-'\t' < 5)
+static void date_pointers(SEXP x, const int **pi, const double **pr);
+static bool decompose(const int *pi, const double *pr, R_xlen_t n, int *py, int *pm, int *pd, int nth);
+
+/* Days are decomposed in blocks of this size by the batch kernel. */
+#define DECOMPOSE_BLOCK 1024
 
 /*
- * From stackoverflow: https://stackoverflow.com/a/79564914
- * user: https://stackoverflow.com/users/17321211/jerichaux
- * License: CC BY-SA 4.0 (https://creativecommons.org/licenses/by-sa/4.0/)
+ * Pointer keyed cache of parsed strings. Only worth using on longer inputs.
+ * Each thread's table is sized from its share of the input (up to
+ * 1 << CACHE_MAX_BITS slots). The cache is abandoned after the first
+ * CACHE_SAMPLE lookups if they have fewer hits than expected for an input
+ * with twice as many distinct strings as the table holds. It is also
+ * abandoned once full if fewer than half of the lookups in a window are hits.
+ * This bounds the overhead for inputs with few repeated strings.
  */
-#define ISLEAP(yearNum) (!(((yearNum) & 3) | ((yearNum) & (((16 - (!((yearNum) % 25))) | 16) ^ 16))))
+#define MIN_CACHE_SIZE 10000
+#define CACHE_MIN_BITS 10
+#define CACHE_MAX_BITS 15
+#define CACHE_SAMPLE 1024
+#define CACHE_WINDOW 4096
+
+struct cache_entry {
+	SEXP key;
+	int value;
+	enum parse_status status;
+};
+
+struct string_cache {
+	struct cache_entry *entries;
+	int bits;
+	int capacity;
+	int count;
+	int lookups;
+	int hits;
+	int sample_hits;
+	bool sampled;
+	bool disabled;
+};
+
+static int cache_bits(R_xlen_t n);
+static void cache_init(struct string_cache *cache, struct cache_entry *entries, int bits);
+static inline bool cache_lookup(struct string_cache *cache, SEXP key, int *value, enum parse_status *status);
+static inline void cache_insert(struct string_cache *cache, SEXP key, int value, enum parse_status status);
 
-#define MAX_YEAR 9999
+/*
+ * With format = "auto" the parser is chosen once from this many leading
+ * non-missing strings rather than per element.
+ */
+#define FORMAT_SAMPLE 100
 
-static int days_in_month(int year, unsigned int month);
-static bool valid_ymd(int year, int month, int day, bool *warn);
+static date_parser as_parser(SEXP format, const SEXP *py, R_xlen_t size);
 
-SEXP ymd(SEXP y, SEXP m, SEXP d)
+/*
+ * Numeric inputs to ymd() are read in place. Doubles are truncated as by
+ * as.integer() and length 1 inputs are recycled by using a zero stride.
+ */
+struct int_input {
+	const int *pi;
+	const double *pr;
+	R_xlen_t stride;
+};
+
+static inline int input_elt(struct int_input in, R_xlen_t i, bool *coerce)
 {
-	R_xlen_t size = XLENGTH(y);
-	SEXP out      = PROTECT(Rf_allocVector(INTSXP, size));
+	if (in.pi)
+		return in.pi[i * in.stride];
+	double v = in.pr[i * in.stride];
+	if (ISNAN(v))
+		return NA_INTEGER;
+	if (v >= INT_MAX + 1. || v <= INT_MIN) {
+		*coerce = true;
+		return NA_INTEGER;
+	}
+	return (int) v;
+}
+
+static struct int_input as_input(SEXP x)
+{
+	struct int_input in = {NULL, NULL, XLENGTH(x) == 1 ? 0 : 1};
+	if (TYPEOF(x) == REALSXP)
+		in.pr = REAL_RO(x);
+	else
+		in.pi = INTEGER_RO(x);
+	return in;
+}
+
+SEXP ymd(SEXP y, SEXP m, SEXP d, SEXP diagnostics, SEXP range_na)
+{
+	if ((!IS_SCALAR(diagnostics, LGLSXP)) || LOGICAL_RO(diagnostics)[0] == NA_LOGICAL)
+		Rf_error("`diagnostics` must be a bool.");
+	if ((!IS_SCALAR(range_na, LGLSXP)) || LOGICAL_RO(range_na)[0] == NA_LOGICAL)
+		Rf_error("`range_na` must be a bool.");
+
+	bool range_na_ = LOGICAL_RO(range_na)[0];
+
+	int protected = 0;
+
+	/* anything other than integers and doubles is coerced as by as.integer() */
+	if (TYPEOF(y) != INTSXP && TYPEOF(y) != REALSXP) {
+		y = PROTECT(Rf_coerceVector(y, INTSXP)); protected++;
+	}
+	if (TYPEOF(m) != INTSXP && TYPEOF(m) != REALSXP) {
+		m = PROTECT(Rf_coerceVector(m, INTSXP)); protected++;
+	}
+	if (TYPEOF(d) != INTSXP && TYPEOF(d) != REALSXP) {
+		d = PROTECT(Rf_coerceVector(d, INTSXP)); protected++;
+	}
+
+	/* inputs must be the same length or length 1 */
+	R_xlen_t ny = XLENGTH(y), nm = XLENGTH(m), nd = XLENGTH(d);
+	R_xlen_t size = ny > nm ? ny : nm;
+	size = size > nd ? size : nd;
+	if (size > 0 && (ny == 0 || nm == 0 || nd == 0))
+		Rf_error("Unable to recycle vectors of length 0.");
+	if ((ny != 1 && ny != size) || (nm != 1 && nm != size) || (nd != 1 && nd != size))
+		Rf_error("`year`, `month` and `day` values must have the same length (or be of length 1).");
+
+	SEXP out      = PROTECT(Rf_allocVector(INTSXP, size)); protected++;
 	int* pout     = INTEGER(out);
-	const int* py = INTEGER_RO(y);
-	const int* pm = INTEGER_RO(m);
-	const int* pd = INTEGER_RO(d);
+	struct int_input py = as_input(y);
+	struct int_input pm = as_input(m);
+	struct int_input pd = as_input(d);
+
+	int nth = num_threads(size);
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	/* failures are only recorded on request */
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc(nth) : NULL;
 
+	/* errors and warnings are raised once all threads have finished */
 	bool warn = false;
-	for (R_xlen_t i = 0; i < size; i++) {
-		int year  = py[i];
-		int month = pm[i];
-		int day   = pd[i];
+	bool warn_range = false;
+	bool coerce = false;
+	R_xlen_t bad = size;
+
+	if (nm == 1 && nd == 1) {
+
+		/* constant month and day so only February 29th depends on the year */
+		const int month = input_elt(pm, 0, &coerce);
+		const int day = input_elt(pd, 0, &coerce);
+		enum { VALID_NA, VALID_NEVER, VALID_LEAP, VALID_ALWAYS } valid;
+		enum parse_status never = PARSE_OK;
+		if (month == NA_INTEGER || day == NA_INTEGER) {
+			valid = VALID_NA;
+		} else if ((never = check_ymd(2000, month, day)) != PARSE_OK) { /* leap year */
+			valid = VALID_NEVER;
+		} else if (month == 2 && day == 29) {
+			valid = VALID_LEAP;
+		} else {
+			valid = VALID_ALWAYS;
+		}
 
-		/* TODO - Is this too harsh? Should we have a flag? */
-		if (year != NA_INTEGER && (abs(year) > MAX_YEAR))
-			Rf_error("Years must be in the range [%d, %d]. y[%td] is %d.", -MAX_YEAR, MAX_YEAR, i, year);
+		#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:warn_range) reduction(||:coerce) reduction(min:bad)
+		for (R_xlen_t i = 0; i < size; i++) {
+			struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+			int year = input_elt(py, i, &coerce);
 
-		if (valid_ymd(year, month, day, &warn)) {
-			pout[i] = days_from_civil(year, month, day);
+			if (year != NA_INTEGER && (abs(year) > MAX_YEAR)) {
+				pout[i] = NA_INTEGER;
+				note_failure(PARSE_YEAR_RANGE, i, diag, range_na_, &warn, &warn_range, &bad);
+				continue;
+			}
+
+			if (year == NA_INTEGER || valid == VALID_NA) {
+				pout[i] = NA_INTEGER;
+			} else if (valid == VALID_NEVER) {
+				pout[i] = NA_INTEGER;
+				note_failure(never, i, diag, range_na_, &warn, &warn_range, &bad);
+			} else if (valid == VALID_LEAP && !ISLEAP(year)) {
+				pout[i] = NA_INTEGER;
+				note_failure(PARSE_BAD_DAY, i, diag, range_na_, &warn, &warn_range, &bad);
+			} else {
+				pout[i] = days_from_civil_kernel(kernel, year, month, day);
+			}
+		}
+
+	} else {
+
+		#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:warn_range) reduction(||:coerce) reduction(min:bad)
+		for (R_xlen_t i = 0; i < size; i++) {
+			struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+			int year  = input_elt(py, i, &coerce);
+			int month = input_elt(pm, i, &coerce);
+			int day   = input_elt(pd, i, &coerce);
+
+			if (year != NA_INTEGER && (abs(year) > MAX_YEAR)) {
+				pout[i] = NA_INTEGER;
+				note_failure(PARSE_YEAR_RANGE, i, diag, range_na_, &warn, &warn_range, &bad);
+				continue;
+			}
+
+			if (year == NA_INTEGER || month == NA_INTEGER || day == NA_INTEGER) {
+				pout[i] = NA_INTEGER;
+				continue;
+			}
+
+			enum parse_status status = check_ymd(year, month, day);
+			if (status == PARSE_OK) {
+				pout[i] = days_from_civil_kernel(kernel, year, month, day);
+				continue;
+			}
+
+			pout[i] = NA_INTEGER;
+			note_failure(status, i, diag, range_na_, &warn, &warn_range, &bad);
+		}
+	}
+
+	if (bad < size)
+		Rf_error("Years must be in the range [%d, %d]. y[%td] is %d.", -MAX_YEAR, MAX_YEAR, bad, input_elt(py, bad, &coerce));
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	/* diagnostics replace the warnings */
+	if (diags) {
+		diagnostics_set(out, diags, nth);
+	} else {
+		if (warn)
+			Rf_warning("NAs introduced due to invalid month and/or day combinations.");
+		if (warn_range)
+			Rf_warning("NAs introduced due to years outside the range [%d, %d].", -MAX_YEAR, MAX_YEAR);
+	}
+
+	/* set class to "Date" before returning */
+	Rf_classgets(out, Rf_mkString("Date"));
+	UNPROTECT(protected);
+	return out;
+}
+
+/* Dates from integer codes year * 10000 + month * 100 + day (e.g. 20250416). */
+SEXP ymd_yyyymmdd(SEXP x, SEXP diagnostics, SEXP range_na)
+{
+	if ((!IS_SCALAR(diagnostics, LGLSXP)) || LOGICAL_RO(diagnostics)[0] == NA_LOGICAL)
+		Rf_error("`diagnostics` must be a bool.");
+	if ((!IS_SCALAR(range_na, LGLSXP)) || LOGICAL_RO(range_na)[0] == NA_LOGICAL)
+		Rf_error("`range_na` must be a bool.");
+
+	bool range_na_ = LOGICAL_RO(range_na)[0];
+
+	int protected = 0;
+
+	/* anything other than integers and doubles is coerced as by as.integer() */
+	if (TYPEOF(x) != INTSXP && TYPEOF(x) != REALSXP) {
+		x = PROTECT(Rf_coerceVector(x, INTSXP)); protected++;
+	}
+
+	R_xlen_t size = XLENGTH(x);
+	struct int_input px = as_input(x);
+	px.stride = 1;
+
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, size)); protected++;
+	int* pout = INTEGER(out);
+
+	int nth = num_threads(size);
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc(nth) : NULL;
+
+	bool warn = false;
+	bool warn_range = false;
+	bool coerce = false;
+	R_xlen_t bad = size;
+
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:warn_range) reduction(||:coerce) reduction(min:bad)
+	for (R_xlen_t i = 0; i < size; i++) {
+		struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+		int code = input_elt(px, i, &coerce);
+		if (code == NA_INTEGER) {
+			pout[i] = NA_INTEGER;
+			continue;
+		}
+
+		int value;
+		enum parse_status status = parse_yyyymmdd_code(code, kernel, &value);
+		if (status == PARSE_OK) {
+			pout[i] = value;
 			continue;
 		}
 
-		/* invalid year */
 		pout[i] = NA_INTEGER;
+		note_failure(status, i, diag, range_na_, &warn, &warn_range, &bad);
 	}
 
-	if (warn)
-		Rf_warning("NAs introduced due to invalid month and/or day combinations.");
+	if (bad < size)
+		Rf_error("Years must be in the range [%d, %d]. x[%td] is %d.", -MAX_YEAR, MAX_YEAR, bad, input_elt(px, bad, &coerce));
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	/* diagnostics replace the warnings */
+	if (diags) {
+		diagnostics_set(out, diags, nth);
+	} else {
+		if (warn)
+			Rf_warning("NAs introduced due to invalid month and/or day combinations.");
+		if (warn_range)
+			Rf_warning("NAs introduced due to years outside the range [%d, %d].", -MAX_YEAR, MAX_YEAR);
+	}
 
-	/* set class to "Date" before returning */
 	Rf_classgets(out, Rf_mkString("Date"));
-	UNPROTECT(1);
+	UNPROTECT(protected);
 	return out;
 }
 
-SEXP ymd_character(SEXP y, SEXP strict)
+SEXP ymd_character(SEXP y, SEXP strict, SEXP diagnostics, SEXP range_na, SEXP format)
 {
 	if ((!IS_SCALAR(strict, LGLSXP)) || LOGICAL_RO(strict)[0] == NA_LOGICAL)
 		Rf_error("`strict` must be a bool.");
+	if ((!IS_SCALAR(diagnostics, LGLSXP)) || LOGICAL_RO(diagnostics)[0] == NA_LOGICAL)
+		Rf_error("`diagnostics` must be a bool.");
+	if ((!IS_SCALAR(range_na, LGLSXP)) || LOGICAL_RO(range_na)[0] == NA_LOGICAL)
+		Rf_error("`range_na` must be a bool.");
 
-	Rboolean strict_ = LOGICAL_RO(strict)[0];
+	bool strict_ = LOGICAL_RO(strict)[0];
+	bool range_na_ = LOGICAL_RO(range_na)[0];
 
 	R_xlen_t size = XLENGTH(y);
 	SEXP out = PROTECT(Rf_allocVector(INTSXP, size));
 	const SEXP* py = STRING_PTR_RO(y);
 	int* pout = INTEGER(out);
+
+	const enum civil_kernel kernel = civil_kernel_option();
+	date_parser parse = as_parser(format, py, size);
+
+	int nth = num_threads(size);
+
+	/* one cache per thread so lookups need no locking */
+	struct string_cache *caches = NULL;
+	struct cache_entry *entries = NULL;
+	int bits = 0;
+	if (size >= MIN_CACHE_SIZE) {
+		bits = cache_bits((size + nth - 1) / nth);
+		caches = (struct string_cache *) R_alloc(nth, sizeof(struct string_cache));
+		entries = (struct cache_entry *) R_alloc((size_t) nth << bits, sizeof(struct cache_entry));
+	}
+
+	/* failures are only recorded on request */
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc(nth) : NULL;
+
+	/* errors and warnings are raised once all threads have finished */
 	bool warn = false;
-	for (R_xlen_t i = 0; i < size; i++) {
+	bool warn_range = false;
+	R_xlen_t bad = size;
+	int bad_year = 0;
+	#pragma omp parallel num_threads(nth) reduction(||:warn) reduction(||:warn_range)
+	{
+		struct string_cache *cache = NULL;
+		if (caches) {
+			/* each thread clears its own table */
+			cache = &caches[thread_num()];
+			cache_init(cache, entries + ((size_t) thread_num() << bits), bits);
+		}
+		struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+
+		#pragma omp for schedule(static)
+		for (R_xlen_t i = 0; i < size; i++) {
+
+			if (py[i] == NA_STRING) {
+				pout[i] = NA_INTEGER;
+				continue;
+			}
+
+			/* R shares CHARSXPs so repeated strings are repeated pointers */
+			int value;
+			enum parse_status status;
+			if (!cache_lookup(cache, py[i], &value, &status)) {
+				const char *c = CHAR(py[i]);
+				status = parse(c, c + LENGTH(py[i]), strict_, kernel, &value);
+				cache_insert(cache, py[i], value, status);
+			}
+
+			if (status == PARSE_OK) {
+				pout[i] = value;
+				continue;
+			}
 
-		if (py[i] == NA_STRING) {
 			pout[i] = NA_INTEGER;
-			continue;
+			if (diag)
+				diagnostics_record(diag, status, i);
+
+			if (status != PARSE_YEAR_RANGE) {
+				warn = true;
+			} else if (range_na_) {
+				warn_range = true;
+			} else {
+				/* only the first out of range year is reported */
+				#pragma omp critical
+				if (i < bad) {
+					bad = i;
+					bad_year = value;
+				}
+			}
 		}
+	}
 
-		const char *c = CHAR(py[i]);
+	if (bad < size)
+		Rf_error("Years must be in the range [%d, %d]. y[%td] is %d.", -MAX_YEAR, MAX_YEAR, bad, bad_year);
+
+	/* diagnostics replace the warnings */
+	if (diags) {
+		diagnostics_set(out, diags, nth);
+	} else {
+		if (warn)
+			Rf_warning("NAs introduced due to invalid date strings.");
+		if (warn_range)
+			Rf_warning("NAs introduced due to years outside the range [%d, %d].", -MAX_YEAR, MAX_YEAR);
+	}
 
-		/* skip leading whitespace */
-		while(ISSPACE(*c))
-			c++;
+	/* set class to "Date" */
+	Rf_classgets(out, Rf_mkString("Date"));
 
-		/* handle negatives */
-		bool negative = false;
-		if (*c == '-') {
-			negative = true;
-			c++;
+
+	UNPROTECT(1);
+	return out;
+}
+
+/*
+ * ymd_columns() splits every column in to chunks of this many elements and
+ * schedules the (column, chunk) pairs dynamically across one thread team.
+ */
+#define COLUMN_CHUNK 16384
+
+struct column_chunk {
+	int col;
+	R_xlen_t from;
+	R_xlen_t to;
+	bool warn;
+	bool warn_range;
+	R_xlen_t bad;
+	int bad_year;
+};
+
+/*
+ * Convert several columns in one call. Character columns are parsed with
+ * the corresponding `format` and numeric columns are read as yyyymmdd codes.
+ * Warnings name the affected columns and are raised once for the whole
+ * call. Diagnostics are returned as a single "diagnostics" attribute, a list
+ * with an element per column.
+ */
+SEXP ymd_columns(SEXP cols, SEXP format, SEXP strict, SEXP diagnostics, SEXP range_na)
+{
+	if (TYPEOF(cols) != VECSXP)
+		Rf_error("`cols` must be a list.");
+	if (TYPEOF(format) != STRSXP || XLENGTH(format) != XLENGTH(cols))
+		Rf_error("`format` must be a character vector with one element per column.");
+	if ((!IS_SCALAR(strict, LGLSXP)) || LOGICAL_RO(strict)[0] == NA_LOGICAL)
+		Rf_error("`strict` must be a bool.");
+	if ((!IS_SCALAR(diagnostics, LGLSXP)) || LOGICAL_RO(diagnostics)[0] == NA_LOGICAL)
+		Rf_error("`diagnostics` must be a bool.");
+	if ((!IS_SCALAR(range_na, LGLSXP)) || LOGICAL_RO(range_na)[0] == NA_LOGICAL)
+		Rf_error("`range_na` must be a bool.");
+
+	bool strict_ = LOGICAL_RO(strict)[0];
+	bool range_na_ = LOGICAL_RO(range_na)[0];
+
+	int ncol = LENGTH(cols);
+	SEXP names = Rf_getAttrib(cols, R_NamesSymbol);
+	SEXP out = PROTECT(Rf_allocVector(VECSXP, ncol));
+	Rf_namesgets(out, names);
+
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	/* resolve the inputs and parsers before any threads start */
+	const SEXP **pstr = (const SEXP **) R_alloc(ncol, sizeof(const SEXP *));
+	struct int_input *pnum = (struct int_input *) R_alloc(ncol, sizeof(struct int_input));
+	date_parser *parsers = (date_parser *) R_alloc(ncol, sizeof(date_parser));
+	int **pout = (int **) R_alloc(ncol, sizeof(int *));
+	R_xlen_t total = 0, nitems = 0;
+	for (int j = 0; j < ncol; j++) {
+		SEXP col = VECTOR_ELT(cols, j);
+		R_xlen_t n = XLENGTH(col);
+		pstr[j] = NULL;
+		if (TYPEOF(col) == STRSXP) {
+			pstr[j] = STRING_PTR_RO(col);
+			parsers[j] = as_parser(Rf_ScalarString(STRING_ELT(format, j)), pstr[j], n);
+		} else if (TYPEOF(col) == INTSXP || TYPEOF(col) == REALSXP) {
+			pnum[j] = as_input(col);
+			pnum[j].stride = 1;
+		} else {
+			Rf_error("Column %d must be a character or numeric vector.", j + 1);
 		}
+		SEXP date = Rf_allocVector(INTSXP, n);
+		SET_VECTOR_ELT(out, j, date);
+		Rf_classgets(date, Rf_mkString("Date"));
+		pout[j] = INTEGER(date);
+		total += n;
+		nitems += (n + COLUMN_CHUNK - 1) / COLUMN_CHUNK;
+	}
 
-		if (!ISDIGIT(*c)) {
-			pout[i] = NA_INTEGER;
-			warn = true;
-			continue;
+	struct column_chunk *items = (struct column_chunk *) R_alloc(nitems, sizeof(struct column_chunk));
+	R_xlen_t *first_item = (R_xlen_t *) R_alloc(ncol + 1, sizeof(R_xlen_t));
+	for (int j = 0, k = 0; j < ncol; j++) {
+		first_item[j] = k;
+		R_xlen_t n = XLENGTH(VECTOR_ELT(cols, j));
+		for (R_xlen_t from = 0; from < n; from += COLUMN_CHUNK, k++) {
+			items[k] = (struct column_chunk) {j, from, n - from < COLUMN_CHUNK ? n : from + COLUMN_CHUNK, false, false, n, 0};
 		}
+	}
+	first_item[ncol] = nitems;
+
+	int nth = num_threads(total);
+
+	/*
+	 * One record per column and thread, combined per column afterwards. A
+	 * thread is handed chunks in increasing order (monotonic) so each record
+	 * holds the first failures the thread saw in its column.
+	 */
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc((R_xlen_t) ncol * nth) : NULL;
+
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(monotonic:dynamic) reduction(||:coerce)
+	for (R_xlen_t k = 0; k < nitems; k++) {
+		struct column_chunk *item = &items[k];
+		struct diagnostics *diag = diags ? &diags[(R_xlen_t) item->col * nth + thread_num()] : NULL;
+		const SEXP *py = pstr[item->col];
+		date_parser parse = parsers[item->col];
+		int *o = pout[item->col];
+
+		for (R_xlen_t i = item->from; i < item->to; i++) {
+			int value;
+			enum parse_status status;
+			if (py) {
+				if (py[i] == NA_STRING) {
+					o[i] = NA_INTEGER;
+					continue;
+				}
+				const char *c = CHAR(py[i]);
+				status = parse(c, c + LENGTH(py[i]), strict_, kernel, &value);
+			} else {
+				int code = input_elt(pnum[item->col], i, &coerce);
+				if (code == NA_INTEGER) {
+					o[i] = NA_INTEGER;
+					continue;
+				}
+				status = parse_yyyymmdd_code(code, kernel, &value);
+			}
 
-		/* Otherwise, string starts (correctly) with digit */
+			if (status == PARSE_OK) {
+				o[i] = value;
+				continue;
+			}
 
-		/* handle the year with arbitrary MAXIMUM */
-		int year = 0;
-		while (ISDIGIT(*c)) {
-			year = year * 10 + (*c - '0');
-			if (year > MAX_YEAR)
-				Rf_error("Years must be in the range [%d, %d]. y[%td] is %d.", -MAX_YEAR, MAX_YEAR, i, negative ? -year : year);
-			c++;
-		}
-		if (negative)
-			year= -year;
-
-		/* skip non-digit values */
-		while (*c != '\0' && !ISDIGIT(*c))
-			c++;
-
-		/* handle the month */
-		bool invalid = false;
-		int month = 0;
-		while (*c && ISDIGIT(*c)) {
-			month = month * 10 + (*c - '0');
-			if (month > 12)	{
-				invalid = true;
-				break;
+			o[i] = NA_INTEGER;
+			if (diag)
+				diagnostics_record(diag, status, i);
+			if (status != PARSE_YEAR_RANGE) {
+				item->warn = true;
+			} else if (range_na_) {
+				item->warn_range = true;
+			} else if (i < item->bad) {
+				item->bad = i;
+				item->bad_year = value;
 			}
-			c++;
 		}
-		if (invalid || month ==  0) {
-			pout[i] = NA_INTEGER;
-			warn = true;
-			continue;
+	}
+
+	/* combine the chunks: the first out of range year is an error */
+	bool any_warn = false, any_range = false;
+	for (R_xlen_t k = 0; k < nitems; k++) {
+		if (items[k].bad < XLENGTH(VECTOR_ELT(cols, items[k].col))) {
+			const char *name = Rf_isNull(names) ? "" : CHAR(STRING_ELT(names, items[k].col));
+			Rf_error("Years must be in the range [%d, %d]. %s[%td] is %d.", -MAX_YEAR, MAX_YEAR, name, items[k].bad, items[k].bad_year);
 		}
+		any_warn |= items[k].warn;
+		any_range |= items[k].warn_range;
+	}
 
-		/* skip non-digit values */
-		while (*c != '\0' && !ISDIGIT(*c))
-			c++;
-
-		/* handle the day */
-		invalid = false;
-		int daysinmonth = days_in_month(year, month);
-		int day = 0;
-		while (*c != '\0' && ISDIGIT(*c)) {
-			day = day * 10 + (*c - '0');
-			if (day > daysinmonth) {
-				invalid = true;
-				break;
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	/* diagnostics replace the warnings */
+	if (diags) {
+		SEXP all = PROTECT(Rf_allocVector(VECSXP, ncol));
+		Rf_namesgets(all, names);
+		for (int j = 0; j < ncol; j++) {
+			SEXP date = VECTOR_ELT(out, j);
+			diagnostics_set(date, diags + (R_xlen_t) j * nth, nth);
+			SET_VECTOR_ELT(all, j, Rf_getAttrib(date, Rf_install("diagnostics")));
+			Rf_setAttrib(date, Rf_install("diagnostics"), R_NilValue);
+		}
+		Rf_setAttrib(out, Rf_install("diagnostics"), all);
+		UNPROTECT(1);
+	} else if (any_warn || any_range) {
+		/* one warning per kind listing the columns affected */
+		for (int kind = 0; kind < 2; kind++) {
+			if (!(kind == 0 ? any_warn : any_range))
+				continue;
+			char buf[512] = "";
+			size_t len = 0;
+			for (int j = 0; j < ncol && len < sizeof(buf) - 1; j++) {
+				bool hit = false;
+				for (R_xlen_t k = first_item[j]; k < first_item[j + 1]; k++)
+					hit |= kind == 0 ? items[k].warn : items[k].warn_range;
+				if (!hit)
+					continue;
+				/* long lists are truncated */
+				const char *name = Rf_isNull(names) ? "" : CHAR(STRING_ELT(names, j));
+				int w = snprintf(buf + len, sizeof(buf) - len, "%s`%s`", len ? ", " : "", name);
+				len = w < 0 ? sizeof(buf) - 1 : len + (size_t) w;
 			}
-			c++;
+			if (kind == 0)
+				Rf_warning("NAs introduced due to invalid dates in column(s) %s.", buf);
+			else
+				Rf_warning("NAs introduced due to years outside the range [%d, %d] in column(s) %s.", -MAX_YEAR, MAX_YEAR, buf);
 		}
-		if (invalid || day ==  0) {
-			pout[i] = NA_INTEGER;
-			warn = true;
+	}
+
+	UNPROTECT(1);
+	return out;
+}
+
+SEXP ymd_hms_character(SEXP y, SEXP strict)
+{
+	if ((!IS_SCALAR(strict, LGLSXP)) || LOGICAL_RO(strict)[0] == NA_LOGICAL)
+		Rf_error("`strict` must be a bool.");
+
+	bool strict_ = LOGICAL_RO(strict)[0];
+
+	R_xlen_t size = XLENGTH(y);
+	SEXP out = PROTECT(Rf_allocVector(REALSXP, size));
+	const SEXP* py = STRING_PTR_RO(y);
+	double* pout = REAL(out);
+
+	int nth = num_threads(size);
+	(void) nth;
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	/* errors and warnings are raised once all threads have finished */
+	bool warn = false;
+	R_xlen_t bad = size;
+	int bad_year = 0;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn)
+	for (R_xlen_t i = 0; i < size; i++) {
+
+		if (py[i] == NA_STRING) {
+			pout[i] = NA_REAL;
 			continue;
 		}
 
-		/* skip trailing whitespace */
-		while(ISSPACE(*c))
-			c++;
-
-		/* if strict we allow nothing at the end */
-		if (strict_ && *c != '\0') {
-			pout[i] = NA_INTEGER;
+		double value;
+		const char *c = CHAR(py[i]);
+		switch (parse_ymd_hms(c, c + LENGTH(py[i]), strict_, kernel, &value)) {
+		case PARSE_OK:
+			pout[i] = value;
+			break;
+		case PARSE_YEAR_RANGE:
+			/* only the first out of range year is reported */
+			pout[i] = NA_REAL;
+			#pragma omp critical
+			if (i < bad) {
+				bad = i;
+				bad_year = (int) value;
+			}
+			break;
+		default:
+			pout[i] = NA_REAL;
 			warn = true;
-			continue;
+			break;
 		}
-		pout[i] = days_from_civil(year, month, day);
 	}
 
-	if (warn)
-		Rf_warning("NAs introduced due to invalid date strings.");
+	if (bad < size)
+		Rf_error("Years must be in the range [%d, %d]. y[%td] is %d.", -MAX_YEAR, MAX_YEAR, bad, bad_year);
 
-	/* set class to "Date" */
-	Rf_classgets(out, Rf_mkString("Date"));
+	if (warn)
+		Rf_warning("NAs introduced due to invalid timestamp strings.");
 
+	/* set class to "POSIXct" in UTC */
+	SEXP class = PROTECT(Rf_allocVector(STRSXP, 2));
+	SET_STRING_ELT(class, 0, Rf_mkChar("POSIXct"));
+	SET_STRING_ELT(class, 1, Rf_mkChar("POSIXt"));
+	Rf_classgets(out, class);
+	Rf_setAttrib(out, Rf_install("tzone"), Rf_mkString("UTC"));
 
-	UNPROTECT(1);
+	UNPROTECT(2);
 	return out;
 }
 
 
 SEXP is_leap_year(SEXP y)
 {
-	int protected = 0;
-
-	/* support doubles coercible to integer */
-	if (TYPEOF(y) == REALSXP) {
-		y = PROTECT(Rf_duplicate(y)); protected ++;
-		double* yy = REAL(y);
-		for (R_xlen_t i = 0; i < XLENGTH(y); i ++)
-			yy[i] = floor(yy[i]);
-		y = PROTECT(Rf_coerceVector(y, INTSXP)); protected ++;
-	} else if (TYPEOF(y) != INTSXP) {
+	/* support doubles coercible to integer (read in place) */
+	const int* pi = TYPEOF(y) == INTSXP ? INTEGER_RO(y) : NULL;
+	const double* pr = TYPEOF(y) == REALSXP ? REAL_RO(y) : NULL;
+	if (pi == NULL && pr == NULL)
 		Rf_error("Input `x` must be a numeric object.");
-	}
 
 	/* How many inputs */
 	R_xlen_t n = XLENGTH(y);
+	int nth = num_threads(n);
+	(void) nth;
 
 	/* vector for results */
-	SEXP out = PROTECT(Rf_allocVector(LGLSXP, n)); protected++;
+	SEXP out = PROTECT(Rf_allocVector(LGLSXP, n));
 	int* pout = INTEGER(out);
 
 	/* loop over input */
-	const int* py = INTEGER_RO(y);
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:coerce)
 	for (R_xlen_t i = 0; i < n; i++) {
-		int value = py[i];
+		int value = day_at(pi, pr, i);
+		if (value == NA_INTEGER && pr && !ISNAN(pr[i]))
+			coerce = true;
 		pout[i] = value == NA_INTEGER ? NA_INTEGER : ISLEAP(value);
 	}
-	UNPROTECT(protected);
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	UNPROTECT(1);
 	return out;
 }
 
@@ -225,18 +740,12 @@ SEXP get_ymd(SEXP x)
 
 	/* How many inputs */
 	R_xlen_t n = XLENGTH(x);
+	int nth = num_threads(n);
 
-	/* if double we want to floor the input before coercing to integer */
-	if (Rf_isReal(x)) {
-		x = PROTECT(Rf_duplicate(x)); protected ++;
-		double* xx = REAL(x);
-		for (R_xlen_t i = 0; i < n; i ++)
-			xx[i] = floor(xx[i]);
-		x = PROTECT(Rf_coerceVector(x, INTSXP)); protected ++;
-	}
-
-	/* from now on x is an integer */
-	const int* px = INTEGER_RO(x);
+	/* doubles are floored as they are read */
+	const int* pi;
+	const double* pr;
+	date_pointers(x, &pi, &pr);
 
 	/* vectors to hold the output */
 	SEXP year = PROTECT(Rf_allocVector(INTSXP, n)); protected ++;
@@ -246,15 +755,9 @@ SEXP get_ymd(SEXP x)
 	int* pm = INTEGER(month);
 	int* pd = INTEGER(day);
 
-	/* loop over input and calculate ymd */
-	for (R_xlen_t i = 0; i < n; i ++) {
-		int value = px[i];
-		if (value == NA_INTEGER) {
-			py[i] = pm[i] = pd[i] = NA_INTEGER;
-			continue;
-		}
-		civil_from_days(value, &py[i], &pm[i], &pd[i]);
-	}
+	/* calculate ymd */
+	if (decompose(pi, pr, n, py, pm, pd, nth))
+		Rf_warning("NAs introduced by coercion to integer range");
 
 	// Create a named list to hold the output
 	const char *names[] = {"year", "month", "day", ""};
@@ -273,33 +776,29 @@ SEXP get_year(SEXP x)
 	if (!Rf_inherits(x, "Date"))
 		Rf_error("Input `x` must be a <Date> object.");
 
+	/* defer the calculation until elements are needed */
+	if (use_lazy_components())
+		return lazy_component(x, COMPONENT_YEAR);
+
 	int protected = 0;
 
 	/* How many inputs */
 	R_xlen_t n = XLENGTH(x);
+	int nth = num_threads(n);
 
-	/* if double we want to floor the input before coercing to integer */
-	if (Rf_isReal(x)) {
-		x = PROTECT(Rf_duplicate(x)); protected ++;
-		double* xx = REAL(x);
-		for (R_xlen_t i = 0; i < n; i ++)
-			xx[i] = floor(xx[i]);
-		x = PROTECT(Rf_coerceVector(x, INTSXP)); protected ++;
-	}
-
-	/* from now on x is an integer */
-	const int* px = INTEGER_RO(x);
+	/* doubles are floored as they are read */
+	const int* pi;
+	const double* pr;
+	date_pointers(x, &pi, &pr);
 
 	/* vectors to hold year output */
 	SEXP year = PROTECT(Rf_allocVector(INTSXP, n)); protected ++;
 	int* py = INTEGER(year);
 
 
-	/* loop over input and calculate year */
-	for (R_xlen_t i = 0; i < n; i ++) {
-		int value = px[i];
-		py[i] = value == NA_INTEGER ? NA_INTEGER : year_from_days(value);
-	}
+	/* calculate year */
+	if (decompose(pi, pr, n, py, NULL, NULL, nth))
+		Rf_warning("NAs introduced by coercion to integer range");
 
 	UNPROTECT(protected);
 
@@ -311,32 +810,28 @@ SEXP get_month(SEXP x)
 	if (!Rf_inherits(x, "Date"))
 		Rf_error("Input `x` must be a <Date> object.");
 
+	/* defer the calculation until elements are needed */
+	if (use_lazy_components())
+		return lazy_component(x, COMPONENT_MONTH);
+
 	int protected = 0;
 
 	/* How many inputs */
 	R_xlen_t n = XLENGTH(x);
+	int nth = num_threads(n);
 
-	/* if double we want to floor the input before coercing to integer */
-	if (Rf_isReal(x)) {
-		x = PROTECT(Rf_duplicate(x)); protected ++;
-		double* xx = REAL(x);
-		for (R_xlen_t i = 0; i < n; i ++)
-			xx[i] = floor(xx[i]);
-		x = PROTECT(Rf_coerceVector(x, INTSXP)); protected ++;
-	}
-
-	/* from now on x is an integer */
-	const int* px = INTEGER_RO(x);
+	/* doubles are floored as they are read */
+	const int* pi;
+	const double* pr;
+	date_pointers(x, &pi, &pr);
 
 	/* vectors to hold month output */
 	SEXP month = PROTECT(Rf_allocVector(INTSXP, n)); protected ++;
 	int* pm = INTEGER(month);
 
-	/* loop over input and calculate month */
-	for (R_xlen_t i = 0; i < n; i ++) {
-		int value = px[i];
-		pm[i] = value == NA_INTEGER ? NA_INTEGER : month_from_days(value);
-	}
+	/* calculate month */
+	if (decompose(pi, pr, n, NULL, pm, NULL, nth))
+		Rf_warning("NAs introduced by coercion to integer range");
 
 	UNPROTECT(protected);
 
@@ -348,62 +843,190 @@ SEXP get_mday(SEXP x)
 	if (!Rf_inherits(x, "Date"))
 		Rf_error("Input `x` must be a <Date> object.");
 
+	/* defer the calculation until elements are needed */
+	if (use_lazy_components())
+		return lazy_component(x, COMPONENT_MDAY);
+
 	int protected = 0;
 
 	/* How many inputs */
 	R_xlen_t n = XLENGTH(x);
+	int nth = num_threads(n);
 
-	/* if double we want to floor the input before coercing to integer */
-	if (Rf_isReal(x)) {
-		x = PROTECT(Rf_duplicate(x)); protected ++;
-		double* xx = REAL(x);
-		for (R_xlen_t i = 0; i < n; i ++)
-			xx[i] = floor(xx[i]);
-		x = PROTECT(Rf_coerceVector(x, INTSXP)); protected ++;
-	}
-
-	/* from now on x is an integer */
-	const int* px = INTEGER_RO(x);
+	/* doubles are floored as they are read */
+	const int* pi;
+	const double* pr;
+	date_pointers(x, &pi, &pr);
 
 	/* vectors to hold day output */
 	SEXP day = PROTECT(Rf_allocVector(INTSXP, n)); protected ++;
 	int* pd = INTEGER(day);
 
-	/* loop over input and calculate month */
-	for (R_xlen_t i = 0; i < n; i ++) {
-		int value = px[i];
-		pd[i] = value == NA_INTEGER ? NA_INTEGER : day_from_days(value);
-	}
+	/* calculate day */
+	if (decompose(pi, pr, n, NULL, NULL, pd, nth))
+		Rf_warning("NAs introduced by coercion to integer range");
 
 	UNPROTECT(protected);
 
 	return day;
 }
 
-static int days_in_month(int year, unsigned int month)
+/*
+ * Parser for a named format. For "auto" each format is tried on a sample of
+ * the input and the first with the most strict matches wins, with matches
+ * ignoring trailing content breaking ties (e.g. for timestamps).
+ */
+static date_parser as_parser(SEXP format, const SEXP *py, R_xlen_t size)
 {
-	const int     days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-	return month == 2 && ISLEAP(year) ? 29 : days[month - 1];
+	if (!IS_SCALAR(format, STRSXP) || STRING_ELT(format, 0) == NA_STRING)
+		Rf_error("`format` must be a string.");
+	const char *name = CHAR(STRING_ELT(format, 0));
+
+	for (int f = 0; date_formats[f].name; f++)
+		if (strcmp(name, date_formats[f].name) == 0)
+			return date_formats[f].parse;
+
+	if (strcmp(name, "auto") != 0)
+		Rf_error("`format` must be one of \"ymd\", \"yyyymmdd\", \"yday\", \"dmy\", \"mdy\" or \"auto\".");
+
+	int best = 0;
+	int best_strict = -1, best_lax = -1;
+	for (int f = 0; date_formats[f].name; f++) {
+		int n_strict = 0, n_lax = 0, sampled = 0;
+		for (R_xlen_t i = 0; i < size && sampled < FORMAT_SAMPLE; i++) {
+			if (py[i] == NA_STRING)
+				continue;
+			sampled++;
+			int value;
+			const char *c = CHAR(py[i]);
+			enum parse_status status = date_formats[f].parse(c, c + LENGTH(py[i]), true, KERNEL_TABLE, &value);
+			n_strict += status == PARSE_OK;
+			n_lax += status == PARSE_OK || status == PARSE_TRAILING;
+		}
+		if (n_strict > best_strict || (n_strict == best_strict && n_lax > best_lax)) {
+			best = f;
+			best_strict = n_strict;
+			best_lax = n_lax;
+		}
+	}
+
+	return date_formats[best].parse;
 }
 
-static bool valid_ymd(int year, int month, int day, bool *warn)
+/* integer or double day numbers of a Date */
+static void date_pointers(SEXP x, const int **pi, const double **pr)
 {
-	if (year == NA_INTEGER || month == NA_INTEGER || day == NA_INTEGER)
-		return false;
+	*pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	*pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (*pi == NULL && *pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+}
 
-	if (month < 1 || month > 12) {
-		*warn = true;
-		return false;
+/*
+ * Decompose days in to year, month and day with the batch (or, for sorted
+ * blocks, incremental) kernel. Outputs
+ * can be NULL in which case that component goes to a scratch buffer and is
+ * discarded. NA (INT_MIN) inputs give NA outputs. Returns true if any
+ * (non-NaN) double was outside the integer range.
+ */
+static bool decompose(const int *pi, const double *pr, R_xlen_t n, int *py, int *pm, int *pd, int nth)
+{
+	const int sorted = sorted_option();
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:coerce)
+	for (R_xlen_t from = 0; from < n; from += DECOMPOSE_BLOCK) {
+		int scratch_z[DECOMPOSE_BLOCK];
+		int scratch_y[DECOMPOSE_BLOCK], scratch_m[DECOMPOSE_BLOCK], scratch_d[DECOMPOSE_BLOCK];
+		R_xlen_t len = n - from < DECOMPOSE_BLOCK ? n - from : DECOMPOSE_BLOCK;
+		const int *z = load_days(pi, pr, from, len, scratch_z);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(
+			z, len,
+			py ? py + from : scratch_y,
+			pm ? pm + from : scratch_m,
+			pd ? pd + from : scratch_d,
+			sorted
+		);
 	}
+	return coerce;
+}
 
+/* bits of a table with a slot for each of n strings, within [CACHE_MIN_BITS, CACHE_MAX_BITS] */
+static int cache_bits(R_xlen_t n)
+{
+	int bits = CACHE_MIN_BITS;
+	while (bits < CACHE_MAX_BITS && ((R_xlen_t) 1 << bits) < n)
+		bits++;
+	return bits;
+}
 
-	if (day < 1 || day > days_in_month(year, month)) {
-		*warn = true;
-		return false;
-	}
-
+static void cache_init(struct string_cache *cache, struct cache_entry *entries, int bits)
+{
+	memset(entries, 0, ((size_t) 1 << bits) * sizeof(struct cache_entry));
+	memset(cache, 0, sizeof(struct string_cache));
+	cache->entries = entries;
+	cache->bits = bits;
+	cache->capacity = (1 << bits) / 4 * 3;
+
+	/* about CACHE_SAMPLE^2 / 2d of the first lookups are repeats for d distinct strings */
+	cache->sample_hits = CACHE_SAMPLE * CACHE_SAMPLE / (4 * cache->capacity);
+	if (cache->sample_hits > CACHE_SAMPLE / 2)
+		cache->sample_hits = CACHE_SAMPLE / 2;
+}
 
-	return true;
+static inline size_t cache_slot(const struct string_cache *cache, SEXP key)
+{
+	/* CHARSXPs are aligned so drop the low bits before mixing */
+	uint64_t h = (uint64_t)(uintptr_t) key >> 4;
+	h *= UINT64_C(0x9E3779B97F4A7C15);
+	return (size_t)(h >> (64 - cache->bits));
 }
 
+static inline bool cache_lookup(struct string_cache *cache, SEXP key, int *value, enum parse_status *status)
+{
+	if (cache == NULL || cache->disabled)
+		return false;
 
+	/* give up on inputs with too few repeated strings */
+	if (cache->lookups == (cache->sampled ? CACHE_WINDOW : CACHE_SAMPLE)) {
+		bool give_up = cache->sampled
+			? cache->hits < CACHE_WINDOW / 2 && cache->count >= cache->capacity
+			: cache->hits < cache->sample_hits;
+		if (give_up) {
+			cache->disabled = true;
+			return false;
+		}
+		cache->sampled = true;
+		cache->lookups = cache->hits = 0;
+	}
+	cache->lookups++;
+
+	/* open addressing with linear probing */
+	const size_t mask = ((size_t) 1 << cache->bits) - 1;
+	for (size_t slot = cache_slot(cache, key); cache->entries[slot].key != NULL; slot = (slot + 1) & mask) {
+		if (cache->entries[slot].key == key) {
+			*value = cache->entries[slot].value;
+			*status = cache->entries[slot].status;
+			cache->hits++;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline void cache_insert(struct string_cache *cache, SEXP key, int value, enum parse_status status)
+{
+	/* stop adding entries once the table is three quarters full */
+	if (cache == NULL || cache->disabled || cache->count >= cache->capacity)
+		return;
+
+	const size_t mask = ((size_t) 1 << cache->bits) - 1;
+	size_t slot = cache_slot(cache, key);
+	while (cache->entries[slot].key != NULL)
+		slot = (slot + 1) & mask;
+
+	cache->entries[slot].key = key;
+	cache->entries[slot].value = value;
+	cache->entries[slot].status = status;
+	cache->count++;
+}
@@ -0,0 +1,400 @@
+#include "calendar.h"
+#include "civil_from_days.h"
+#include "days.h"
+#include "days_from_civil.h"
+#include "threads.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Calendar arithmetic on Dates. Days are decomposed a block at a time by the
+ * batch kernel and composed again in the same pass so no intermediate year,
+ * month or day vectors are ever allocated.
+ */
+
+#define ARITH_BLOCK 1024
+
+/* results beyond this many years either side of the epoch would overflow */
+#define ARITH_MAX_YEAR 5000000
+
+enum unit { UNIT_MONTH, UNIT_QUARTER, UNIT_YEAR };
+
+static enum unit as_unit(SEXP unit)
+{
+	if (!IS_SCALAR(unit, STRSXP) || STRING_ELT(unit, 0) == NA_STRING)
+		Rf_error("`unit` must be a string.");
+	const char *u = CHAR(STRING_ELT(unit, 0));
+	if (strcmp(u, "month") == 0)
+		return UNIT_MONTH;
+	if (strcmp(u, "quarter") == 0)
+		return UNIT_QUARTER;
+	if (strcmp(u, "year") == 0)
+		return UNIT_YEAR;
+	Rf_error("`unit` must be one of \"month\", \"quarter\" or \"year\".");
+}
+
+/* integer output with the class and names of a Date */
+static SEXP alloc_date(SEXP x, R_xlen_t n)
+{
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, n));
+	Rf_classgets(out, Rf_mkString("Date"));
+	Rf_namesgets(out, Rf_getAttrib(x, R_NamesSymbol));
+	UNPROTECT(1);
+	return out;
+}
+
+static SEXP round_ymd(SEXP x, SEXP unit, bool ceiling)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	enum unit unit_ = as_unit(unit);
+
+	R_xlen_t n = XLENGTH(x);
+	SEXP out = PROTECT(alloc_date(x, n));
+	int *pout = INTEGER(out);
+
+	int nth = num_threads(n);
+	(void) nth;
+	const int sorted = sorted_option();
+
+	/* warnings are raised once all threads have finished */
+	bool warn = false;
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:coerce)
+	for (R_xlen_t from = 0; from < n; from += ARITH_BLOCK) {
+		int buf[ARITH_BLOCK], year[ARITH_BLOCK], month[ARITH_BLOCK], day[ARITH_BLOCK];
+		R_xlen_t len = n - from < ARITH_BLOCK ? n - from : ARITH_BLOCK;
+		const int *z = load_days(pi, pr, from, len, buf);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		int *o = pout + from;
+		for (R_xlen_t i = 0; i < len; i++) {
+			if (z[i] == NA_INTEGER) {
+				o[i] = NA_INTEGER;
+				continue;
+			}
+			const int y = year[i];
+
+			/* as for add_months(), the result could overflow */
+			if (y < -ARITH_MAX_YEAR || y > ARITH_MAX_YEAR) {
+				o[i] = NA_INTEGER;
+				warn = true;
+				continue;
+			}
+			const unsigned m = month[i];
+			switch (unit_) {
+			case UNIT_MONTH:
+				/* no need to recompose for months */
+				o[i] = ceiling
+					? z[i] - day[i] + days_in_month(y, m)
+					: z[i] - day[i] + 1;
+				break;
+			case UNIT_QUARTER: {
+				const unsigned first = (m - 1) / 3 * 3 + 1;
+				o[i] = ceiling
+					? days_from_civil_fast(y, first + 2, days_in_month(y, first + 2))
+					: days_from_civil_fast(y, first, 1);
+				break;
+			}
+			case UNIT_YEAR:
+				o[i] = ceiling ? days_from_civil_fast(y, 12, 31) : days_from_civil_fast(y, 1, 1);
+				break;
+			}
+		}
+	}
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+	if (warn)
+		Rf_warning("NAs introduced due to out of range dates.");
+
+	UNPROTECT(1);
+	return out;
+}
+
+SEXP floor_ymd(SEXP x, SEXP unit)
+{
+	return round_ymd(x, unit, false);
+}
+
+SEXP ceiling_ymd(SEXP x, SEXP unit)
+{
+	return round_ymd(x, unit, true);
+}
+
+SEXP add_months(SEXP x, SEXP n, SEXP clamp)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	R_xlen_t size = XLENGTH(x);
+	if (TYPEOF(n) != INTSXP || (XLENGTH(n) != 1 && XLENGTH(n) != size))
+		Rf_error("`n` must be an integer vector of length 1 or the same length as `x`.");
+	if ((!IS_SCALAR(clamp, LGLSXP)) || LOGICAL_RO(clamp)[0] == NA_LOGICAL)
+		Rf_error("`clamp` must be a bool.");
+
+	const int *pn = INTEGER_RO(n);
+	const R_xlen_t stride = XLENGTH(n) == 1 ? 0 : 1;
+	const bool clamp_ = LOGICAL_RO(clamp)[0];
+
+	SEXP out = PROTECT(alloc_date(x, size));
+	int *pout = INTEGER(out);
+
+	int nth = num_threads(size);
+	(void) nth;
+	const int sorted = sorted_option();
+
+	/* warnings are raised once all threads have finished */
+	bool warn = false;
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:coerce)
+	for (R_xlen_t from = 0; from < size; from += ARITH_BLOCK) {
+		int buf[ARITH_BLOCK], year[ARITH_BLOCK], month[ARITH_BLOCK], day[ARITH_BLOCK];
+		R_xlen_t len = size - from < ARITH_BLOCK ? size - from : ARITH_BLOCK;
+		const int *z = load_days(pi, pr, from, len, buf);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		int *o = pout + from;
+		for (R_xlen_t i = 0; i < len; i++) {
+			const int months = pn[(from + i) * stride];
+			if (z[i] == NA_INTEGER || months == NA_INTEGER) {
+				o[i] = NA_INTEGER;
+				continue;
+			}
+
+			/* months since year 0 with floored division back to years */
+			const long long total = (long long) year[i] * 12 + (month[i] - 1) + months;
+			const long long y = total >= 0 ? total / 12 : (total - 11) / 12;
+			if (y < -ARITH_MAX_YEAR || y > ARITH_MAX_YEAR) {
+				o[i] = NA_INTEGER;
+				warn = true;
+				continue;
+			}
+			const unsigned m = (unsigned) (total - y * 12) + 1;
+
+			int d = day[i];
+			const int dim = days_in_month((int) y, m);
+			if (d > dim) {
+				if (!clamp_) {
+					o[i] = NA_INTEGER;
+					continue;
+				}
+				d = dim;
+			}
+			o[i] = days_from_civil_fast((int) y, m, d);
+		}
+	}
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+	if (warn)
+		Rf_warning("NAs introduced due to out of range dates.");
+
+	UNPROTECT(1);
+	return out;
+}
+
+/* --------------------------------------------------------------------------
+ Period keys. By default a key counts the periods since the start of 1970
+ (so keys are dense) but calendar keys (yyyymm, yyyyq or yyyy) can be used.
+ -------------------------------------------------------------------------- */
+
+/* a span of more periods than this cannot be counted */
+#define MAX_PERIODS (1 << 20)
+
+static inline int period_index(int year, int month, enum unit unit)
+{
+	switch (unit) {
+	case UNIT_MONTH:
+		return (year - 1970) * 12 + (month - 1);
+	case UNIT_QUARTER:
+		return (year - 1970) * 4 + (month - 1) / 3;
+	case UNIT_YEAR:
+		return year - 1970;
+	}
+	return 0;
+}
+
+static inline int period_calendar(int year, int month, enum unit unit)
+{
+	switch (unit) {
+	case UNIT_MONTH:
+		return year * 100 + month;
+	case UNIT_QUARTER:
+		return year * 10 + (month - 1) / 3 + 1;
+	case UNIT_YEAR:
+		return year;
+	}
+	return 0;
+}
+
+/* first day of the period with the given index */
+static inline int period_start(int index, enum unit unit)
+{
+	int per_year = unit == UNIT_MONTH ? 12 : unit == UNIT_QUARTER ? 4 : 1;
+	int year = 1970 + (index >= 0 ? index / per_year : (index - per_year + 1) / per_year);
+	int month = (index - (year - 1970) * per_year) * (12 / per_year) + 1;
+	return days_from_civil_fast(year, month, 1);
+}
+
+SEXP period_key(SEXP x, SEXP unit, SEXP calendar)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	enum unit unit_ = as_unit(unit);
+	if ((!IS_SCALAR(calendar, LGLSXP)) || LOGICAL_RO(calendar)[0] == NA_LOGICAL)
+		Rf_error("`calendar` must be a bool.");
+	const bool calendar_ = LOGICAL_RO(calendar)[0];
+
+	R_xlen_t n = XLENGTH(x);
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, n));
+	Rf_namesgets(out, Rf_getAttrib(x, R_NamesSymbol));
+	int *pout = INTEGER(out);
+
+	int nth = num_threads(n);
+	(void) nth;
+	const int sorted = sorted_option();
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:coerce)
+	for (R_xlen_t from = 0; from < n; from += ARITH_BLOCK) {
+		int buf[ARITH_BLOCK], year[ARITH_BLOCK], month[ARITH_BLOCK], day[ARITH_BLOCK];
+		R_xlen_t len = n - from < ARITH_BLOCK ? n - from : ARITH_BLOCK;
+		const int *z = load_days(pi, pr, from, len, buf);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		int *o = pout + from;
+		for (R_xlen_t i = 0; i < len; i++) {
+			if (z[i] == NA_INTEGER)
+				o[i] = NA_INTEGER;
+			else if (calendar_)
+				o[i] = period_calendar(year[i], month[i], unit_);
+			else
+				o[i] = period_index(year[i], month[i], unit_);
+		}
+	}
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	UNPROTECT(1);
+	return out;
+}
+
+SEXP count_by_period(SEXP x, SEXP unit)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	enum unit unit_ = as_unit(unit);
+
+	R_xlen_t n = XLENGTH(x);
+	int nth = num_threads(n);
+
+	/* keys increase with the day so the range of days gives the range of keys */
+	int lo = INT_MAX, hi = INT_MIN;
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(min:lo) reduction(max:hi) reduction(||:coerce)
+	for (R_xlen_t i = 0; i < n; i++) {
+		int z = day_at(pi, pr, i);
+		if (z != NA_INTEGER) {
+			lo = z < lo ? z : lo;
+			hi = z > hi ? z : hi;
+		} else if (pr && !ISNAN(pr[i])) {
+			coerce = true;
+		}
+	}
+
+	int first = 0, span = 0;
+	if (lo <= hi) {
+		int y, m, d;
+		civil_from_days(lo, &y, &m, &d);
+		first = period_index(y, m, unit_);
+		civil_from_days(hi, &y, &m, &d);
+		if ((long long) period_index(y, m, unit_) - first + 1 > MAX_PERIODS)
+			Rf_error("`x` spans more than %d periods.", MAX_PERIODS);
+		span = period_index(y, m, unit_) - first + 1;
+	}
+
+	/* one histogram per thread so counting needs no locking */
+	R_xlen_t *counts = (R_xlen_t *) R_alloc((size_t) nth * span + 1, sizeof(R_xlen_t));
+	memset(counts, 0, ((size_t) nth * span + 1) * sizeof(R_xlen_t));
+
+	const int sorted = sorted_option();
+	#pragma omp parallel for num_threads(nth) schedule(static)
+	for (R_xlen_t from = 0; from < n; from += ARITH_BLOCK) {
+		int buf[ARITH_BLOCK], year[ARITH_BLOCK], month[ARITH_BLOCK], day[ARITH_BLOCK];
+		R_xlen_t len = n - from < ARITH_BLOCK ? n - from : ARITH_BLOCK;
+		const int *z = load_days(pi, pr, from, len, buf);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		R_xlen_t *local = counts + (size_t) thread_num() * span;
+		for (R_xlen_t i = 0; i < len; i++)
+			if (z[i] != NA_INTEGER)
+				local[period_index(year[i], month[i], unit_) - first]++;
+	}
+
+	/* combine in to the first histogram */
+	int nonzero = 0;
+	for (int j = 0; j < span; j++) {
+		for (int t = 1; t < nth; t++)
+			counts[j] += counts[(size_t) t * span + j];
+		nonzero += counts[j] > 0;
+	}
+
+	/* only periods containing dates are returned */
+	SEXP period = PROTECT(Rf_allocVector(INTSXP, nonzero));
+	SEXP count = PROTECT(Rf_allocVector(n > INT_MAX ? REALSXP : INTSXP, nonzero));
+	for (int j = 0, k = 0; j < span; j++) {
+		if (counts[j] == 0)
+			continue;
+		INTEGER(period)[k] = period_start(first + j, unit_);
+		if (TYPEOF(count) == INTSXP)
+			INTEGER(count)[k] = (int) counts[j];
+		else
+			REAL(count)[k] = (double) counts[j];
+		k++;
+	}
+	Rf_classgets(period, Rf_mkString("Date"));
+
+	const char *names[] = {"period", "n", ""};
+	SEXP out = PROTECT(Rf_mkNamed(VECSXP, names));
+	SET_VECTOR_ELT(out, 0, period);
+	SET_VECTOR_ELT(out, 1, count);
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	UNPROTECT(3);
+	return out;
+}
@@ -0,0 +1,19 @@
+#ifndef FASTYMD_CALENDAR_H
+#define FASTYMD_CALENDAR_H
+
+/*
+ * From stackoverflow: https://stackoverflow.com/a/79564914
+ * user: https://stackoverflow.com/users/17321211/jerichaux
+ * License: CC BY-SA 4.0 (https://creativecommons.org/licenses/by-sa/4.0/)
+ */
+#define ISLEAP(yearNum) (!(((yearNum) & 3) | ((yearNum) & (((16 - (!((yearNum) % 25))) | 16) ^ 16))))
+
+#define MAX_YEAR 9999
+
+static inline int days_in_month(int year, unsigned int month)
+{
+	static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	return month == 2 && ISLEAP(year) ? 29 : days[month - 1];
+}
+
+#endif
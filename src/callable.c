@@ -0,0 +1,73 @@
+#include "callable.h"
+#include "calendar.h"
+#include "civil_from_days.h"
+#include "days_from_civil.h"
+#include "parse.h"
+
+#include <fastymd.h>
+
+#include <stdlib.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <R_ext/Rdynload.h>
+
+/*
+ * Entry points registered with R_RegisterCCallable() for other packages.
+ * These take and return plain ints (rather than bool and enum) so that the
+ * types in the installed header are stable.
+ */
+
+static int c_days_from_civil(int year, int month, int day)
+{
+	if (year == NA_INTEGER || month == NA_INTEGER || day == NA_INTEGER || abs(year) > MAX_YEAR)
+		return NA_INTEGER;
+	if (check_ymd(year, month, day) != PARSE_OK)
+		return NA_INTEGER;
+	return days_from_civil_fast(year, month, day);
+}
+
+static void c_civil_from_days(int days, int *year, int *month, int *day)
+{
+	if (days == NA_INTEGER) {
+		*year = *month = *day = NA_INTEGER;
+		return;
+	}
+	civil_from_days(days, year, month, day);
+}
+
+/* independent of the `fastymd.kernel` option, as are all entry points here */
+static int c_parse_ymd(const char *x, size_t len, int strict, int *days)
+{
+	switch (parse_ymd(x, x + len, strict != 0, KERNEL_TABLE, days)) {
+	case PARSE_OK:
+		return FASTYMD_PARSE_OK;
+	case PARSE_YEAR_RANGE:
+		return FASTYMD_PARSE_YEAR_RANGE;
+	case PARSE_BAD_YEAR:
+		return FASTYMD_PARSE_BAD_YEAR;
+	case PARSE_BAD_MONTH:
+		return FASTYMD_PARSE_BAD_MONTH;
+	case PARSE_TRAILING:
+		return FASTYMD_PARSE_TRAILING;
+	default:
+		return FASTYMD_PARSE_BAD_DAY;
+	}
+}
+
+static void c_days_from_civil_n(const int *year, const int *month, const int *day, ptrdiff_t n, int *days)
+{
+	for (ptrdiff_t i = 0; i < n; i++)
+		days[i] = c_days_from_civil(year[i], month[i], day[i]);
+}
+
+void init_callables(void)
+{
+	R_RegisterCCallable("fastymd", "days_from_civil", (DL_FUNC) &c_days_from_civil);
+	R_RegisterCCallable("fastymd", "civil_from_days", (DL_FUNC) &c_civil_from_days);
+	R_RegisterCCallable("fastymd", "parse_ymd", (DL_FUNC) &c_parse_ymd);
+	R_RegisterCCallable("fastymd", "days_from_civil_n", (DL_FUNC) &c_days_from_civil_n);
+	R_RegisterCCallable("fastymd", "civil_from_days_n", (DL_FUNC) &civil_from_days_n);
+	R_RegisterCCallable("fastymd", "civil_from_days_sorted_n", (DL_FUNC) &civil_from_days_sorted_n);
+}
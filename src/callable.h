@@ -0,0 +1,7 @@
+#ifndef FASTYMD_CALLABLE_H
+#define FASTYMD_CALLABLE_H
+
+/* Register the C API of inst/include/fastymd.h. */
+void init_callables(void);
+
+#endif
@@ -43,12 +43,16 @@
  -------------------------------------------------------------------------- */
 
 #include "civil_from_days.h"
+#include "calendar.h"
+
+#include <limits.h>
+#include <stdint.h>
 
 void civil_from_days(int z, int *year, int *month, int *day)
 {
-	z += 719468;
-	const int era = (z >= 0 ? z : z - 146096) / 146097;
-	const unsigned doe = (unsigned)(z - era * 146097);          // [0, 146096]
+	const int64_t zz = (int64_t) z + 719468;                    // no overflow near INT_MAX
+	const int era = (int) ((zz >= 0 ? zz : zz - 146096) / 146097);
+	const unsigned doe = (unsigned)(zz - (int64_t) era * 146097); // [0, 146096]
 	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
 	const int y = (int)(yoe) + era * 400;
 	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
@@ -63,9 +67,9 @@ void civil_from_days(int z, int *year, int *month, int *day)
 
 int year_from_days(int z)
 {
-	z += 719468;
-	const int era = (z >= 0 ? z : z - 146096) / 146097;
-	const unsigned doe = (unsigned)(z - era * 146097);          // [0, 146096]
+	const int64_t zz = (int64_t) z + 719468;                    // no overflow near INT_MAX
+	const int era = (int) ((zz >= 0 ? zz : zz - 146096) / 146097);
+	const unsigned doe = (unsigned)(zz - (int64_t) era * 146097); // [0, 146096]
 	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
 	const int y = (int)(yoe) + era * 400;
 	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
@@ -77,9 +81,9 @@ int year_from_days(int z)
 
 int month_from_days(int z)
 {
-	z += 719468;
-	const int era = (z >= 0 ? z : z - 146096) / 146097;
-	const unsigned doe = (unsigned)(z - era * 146097);          // [0, 146096]
+	const int64_t zz = (int64_t) z + 719468;                    // no overflow near INT_MAX
+	const int era = (int) ((zz >= 0 ? zz : zz - 146096) / 146097);
+	const unsigned doe = (unsigned)(zz - (int64_t) era * 146097); // [0, 146096]
 	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
 	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
 	const unsigned mp = (5 * doy + 2) / 153;                                   // [0, 11]
@@ -90,9 +94,9 @@ int month_from_days(int z)
 
 int day_from_days(int z)
 {
-	z += 719468;
-	const int era = (z >= 0 ? z : z - 146096) / 146097;
-	const unsigned doe = (unsigned)(z - era * 146097);          // [0, 146096]
+	const int64_t zz = (int64_t) z + 719468;                    // no overflow near INT_MAX
+	const int era = (int) ((zz >= 0 ? zz : zz - 146096) / 146097);
+	const unsigned doe = (unsigned)(zz - (int64_t) era * 146097); // [0, 146096]
 	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;  // [0, 399]
 	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);                // [0, 365]
 	const unsigned mp = (5 * doy + 2) / 153;                                   // [0, 11]
@@ -100,3 +104,169 @@ int day_from_days(int z)
 
 	return d;
 }
+
+/* --------------------------------------------------------------------------
+ Batch conversion using the Euclidean affine function formulation of
+ civil_from_days described by Cassio Neri and Lorenz Schneider in:
+
+ Neri C, Schneider L. (2023) "Euclidean affine functions and their
+ application to calendar algorithms". Software: Practice and Experience;
+ 53(4):937-970. https://doi.org/10.1002/spe.3172
+
+ Days are shifted by a multiple of 400 years so that all arithmetic is
+ unsigned and the divisions become multiply-shifts. The loop body has no
+ branches so compilers can vectorise it. Inputs outside the range supported
+ by the shift (and NA, i.e. INT_MIN) are handled afterwards by falling back
+ to civil_from_days().
+ -------------------------------------------------------------------------- */
+
+#define NS_SHIFT 82u                                 /* 400 year periods */
+#define NS_K     (719468u + 146097u * NS_SHIFT)      /* epoch offset */
+#define NS_L     (400u * NS_SHIFT)                   /* year offset */
+#define NS_MIN   (-(int) NS_K)
+#define NS_MAX   ((int) (1073741823u - NS_K))
+
+/* --------------------------------------------------------------------------
+ Lookup table for days in the years 1900 to 2100 (inclusive). Each
+ entry packs the year (16 bits), month (4 bits) and day (5 bits) in to a
+ single uint32_t so the whole table (~290KB) sits comfortably in L2 cache.
+ Blocks of days that lie entirely within the window are converted with one
+ load per element instead of the arithmetic.
+ -------------------------------------------------------------------------- */
+
+#define TABLE_MIN_DAY  (-25567)                      /* 1900-01-01 */
+#define TABLE_MAX_DAY  47846                         /* 2100-12-31 */
+
+static uint32_t civil_table[TABLE_MAX_DAY - TABLE_MIN_DAY + 1];
+
+void init_civil_from_days_table(void)
+{
+	for (int z = TABLE_MIN_DAY; z <= TABLE_MAX_DAY; z++) {
+		int y, m, d;
+		civil_from_days(z, &y, &m, &d);
+		civil_table[z - TABLE_MIN_DAY] = ((uint32_t) y << 9) | ((uint32_t) m << 5) | (uint32_t) d;
+	}
+}
+
+static void civil_from_days_table(const int *restrict z, ptrdiff_t n, int *restrict year, int *restrict month, int *restrict day)
+{
+	for (ptrdiff_t i = 0; i < n; i++) {
+		const uint32_t packed = civil_table[z[i] - TABLE_MIN_DAY];
+		year[i] = (int) (packed >> 9);
+		month[i] = (int) ((packed >> 5) & 15);
+		day[i] = (int) (packed & 31);
+	}
+}
+
+void civil_from_days_n(const int *restrict z, ptrdiff_t n, int *restrict year, int *restrict month, int *restrict day)
+{
+	/* use the table if every day falls within it */
+	int in_table = 1;
+	for (ptrdiff_t i = 0; i < n; i++)
+		in_table &= (z[i] >= TABLE_MIN_DAY) & (z[i] <= TABLE_MAX_DAY);
+	if (in_table) {
+		civil_from_days_table(z, n, year, month, day);
+		return;
+	}
+
+	int out_of_range = 0;
+
+	for (ptrdiff_t i = 0; i < n; i++) {
+		const int v = z[i];
+		out_of_range |= (v < NS_MIN) | (v > NS_MAX);
+
+		const uint32_t N = (uint32_t) v + NS_K;
+
+		/* century and day of century */
+		const uint32_t N_1 = 4 * N + 3;
+		const uint32_t C = N_1 / 146097;
+		const uint32_t N_C = N_1 % 146097 / 4;
+
+		/* year of century and day of year */
+		const uint32_t N_2 = 4 * N_C + 3;
+		const uint64_t P_2 = (uint64_t) 2939745 * N_2;
+		const uint32_t Z = (uint32_t) (P_2 >> 32);
+		const uint32_t N_Y = (uint32_t) P_2 / 2939745 / 4;
+
+		/* month and day (March based) */
+		const uint32_t N_3 = 2141 * N_Y + 197913;
+		const uint32_t M = N_3 >> 16;
+		const uint32_t D = (N_3 & 0xFFFF) / 2141;
+
+		/* map back to January based years */
+		const uint32_t J = N_Y >= 306;
+		year[i] = (int) (100 * C + Z + J - NS_L);
+		month[i] = (int) (J ? M - 12 : M);
+		day[i] = (int) D + 1;
+	}
+
+	if (!out_of_range)
+		return;
+
+	for (ptrdiff_t i = 0; i < n; i++) {
+		const int v = z[i];
+		if (v >= NS_MIN && v <= NS_MAX)
+			continue;
+		if (v == INT_MIN)
+			year[i] = month[i] = day[i] = INT_MIN;
+		else
+			civil_from_days(v, &year[i], &month[i], &day[i]);
+	}
+}
+
+/* --------------------------------------------------------------------------
+ Incremental conversion for sorted (or mostly sorted) days such as daily
+ sequences and regular panels. The days of the current month are tracked as
+ a window [lo, hi] so each element inside it needs just a subtraction for
+ the day. Steps forward of at most SORTED_MAX_STEP days advance the window
+ month by month with compares rather than divisions. Anything else (the
+ first element, large jumps or going back to an earlier month) is converted
+ in full.
+ -------------------------------------------------------------------------- */
+
+#define SORTED_MAX_STEP 31
+
+void civil_from_days_sorted_n(const int *restrict z, ptrdiff_t n, int *restrict year, int *restrict month, int *restrict day)
+{
+	/* 64 bit so the window end cannot overflow near INT_MAX */
+	int64_t lo = 1, hi = 0;
+	int y = 0, m = 0;
+
+	for (ptrdiff_t i = 0; i < n; i++) {
+		const int v = z[i];
+
+		if (v < lo || v > hi) {
+			if (v == INT_MIN) {
+				year[i] = month[i] = day[i] = INT_MIN;
+				continue;
+			}
+			if (v > hi && hi >= lo && v - hi <= SORTED_MAX_STEP) {
+				do {
+					lo = hi + 1;
+					if (++m > 12) {
+						m = 1;
+						y++;
+					}
+					hi = lo + days_in_month(y, m) - 1;
+				} while (v > hi);
+			} else {
+				int d;
+				civil_from_days(v, &y, &m, &d);
+				lo = (int64_t) v - d + 1;
+				hi = lo + days_in_month(y, m) - 1;
+			}
+		}
+
+		year[i] = y;
+		month[i] = m;
+		day[i] = (int) (v - lo) + 1;
+	}
+}
+
+int is_sorted_run(const int *z, ptrdiff_t n)
+{
+	int ok = 1;
+	for (ptrdiff_t i = 1; i < n; i++)
+		ok &= ((unsigned) z[i] - (unsigned) z[i - 1] <= SORTED_MAX_STEP) & (z[i - 1] != INT_MIN);
+	return ok;
+}
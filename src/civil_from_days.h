@@ -1,9 +1,26 @@
 #ifndef FASTYMD_CIVIL_FROM_DAYS_H
 #define FASTYMD_CIVIL_FROM_DAYS_H
 
+#include <stddef.h>
+
 void civil_from_days(int z, int *year, int *month, int *day);
 int year_from_days(int z);
 int month_from_days(int z);
 int day_from_days(int z);
 
+/* Batch civil_from_days(). NA (INT_MIN) inputs give NA outputs. */
+void civil_from_days_n(const int *z, ptrdiff_t n, int *year, int *month, int *day);
+
+/*
+ * As civil_from_days_n() but advancing from the previous element for small
+ * forward steps. Correct for any input but only faster for sorted days.
+ */
+void civil_from_days_sorted_n(const int *z, ptrdiff_t n, int *year, int *month, int *day);
+
+/* Are the first n days non-missing and increasing in small steps? */
+int is_sorted_run(const int *z, ptrdiff_t n);
+
+/* Must be called (once) before civil_from_days_n(). */
+void init_civil_from_days_table(void);
+
 #endif
@@ -0,0 +1,183 @@
+#include "calendar.h"
+#include "days.h"
+#include "days_from_civil.h"
+#include "posixct.h"
+#include "threads.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Calendar components of Dates (or POSIXct times in a given time zone)
+ * computed together in a single pass. Each
+ * block of days is decomposed in to year, month and day as for get_ymd()
+ * and the other components are derived from these with table lookups and
+ * compares (the only division is by the constant 7).
+ */
+
+#define COMPONENT_BLOCK 1024
+
+/* codes as in the `components` argument of get_ymd() (less one) */
+enum date_component {
+	DATE_YEAR,
+	DATE_MONTH,
+	DATE_DAY,
+	DATE_WDAY,
+	DATE_YDAY,
+	DATE_ISOWEEK,
+	DATE_ISOYEAR,
+	N_DATE_COMPONENTS
+};
+
+static const char *component_names[N_DATE_COMPONENTS] = {
+	"year", "month", "day", "wday", "yday", "isoweek", "isoyear"
+};
+
+/* ISO weekday (Monday is 1) of a day number; 1970-01-01 was a Thursday */
+static inline int iso_wday(int z)
+{
+	int r = (int) (((int64_t) z + 3) % 7);
+	return (r < 0 ? r + 7 : r) + 1;
+}
+
+static inline int year_length(int y)
+{
+	return 365 + ISLEAP(y);
+}
+
+/*
+ * ISO week and year. Weeks belong to the year of their Thursday so only the
+ * days near the start and end of a year can fall in a neighbouring one.
+ */
+static inline void iso_week(int y, int yday, int wday, int *week, int *year)
+{
+	int thursday = yday + 4 - wday;
+	if (thursday < 1) {
+		y--;
+		thursday += year_length(y);
+	} else if (thursday > year_length(y)) {
+		thursday -= year_length(y);
+		y++;
+	}
+	*week = (thursday - 1) / 7 + 1;
+	*year = y;
+}
+
+/* days are read from pi or pr as Dates, or from pr as POSIXct if tz is not NULL */
+static SEXP compute_components(const int *pi, const double *pr, R_xlen_t n, SEXP components, const struct tz_table *tz)
+{
+	if (TYPEOF(components) != INTSXP || XLENGTH(components) == 0)
+		Rf_error("`components` must be a non-empty integer vector.");
+	const int nc = LENGTH(components);
+	const int *pc = INTEGER_RO(components);
+	for (int k = 0; k < nc; k++) {
+		if (pc[k] == NA_INTEGER || pc[k] < 1 || pc[k] > N_DATE_COMPONENTS)
+			Rf_error("`components` must be between 1 and %d.", N_DATE_COMPONENTS);
+	}
+
+	/* output list in the requested order; p[] is NULL for unrequested components */
+	SEXP out = PROTECT(Rf_allocVector(VECSXP, nc));
+	SEXP names = PROTECT(Rf_allocVector(STRSXP, nc));
+	int *p[N_DATE_COMPONENTS] = {NULL};
+	for (int k = 0; k < nc; k++) {
+		const int c = pc[k] - 1;
+		if (p[c] == NULL) {
+			SET_VECTOR_ELT(out, k, Rf_allocVector(INTSXP, n));
+			p[c] = INTEGER(VECTOR_ELT(out, k));
+		} else {
+			/* repeated components share the first result */
+			for (int j = 0; j < k; j++)
+				if (pc[j] - 1 == c)
+					SET_VECTOR_ELT(out, k, VECTOR_ELT(out, j));
+		}
+		SET_STRING_ELT(names, k, Rf_mkChar(component_names[c]));
+	}
+	Rf_namesgets(out, names);
+
+	const bool extra = p[DATE_WDAY] || p[DATE_YDAY] || p[DATE_ISOWEEK] || p[DATE_ISOYEAR];
+	const bool iso = p[DATE_ISOWEEK] || p[DATE_ISOYEAR];
+
+	int nth = num_threads(n);
+	(void) nth;
+	const int sorted = sorted_option();
+	bool coerce = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:coerce)
+	for (R_xlen_t from = 0; from < n; from += COMPONENT_BLOCK) {
+		int buf[COMPONENT_BLOCK], year[COMPONENT_BLOCK], month[COMPONENT_BLOCK], day[COMPONENT_BLOCK];
+		R_xlen_t len = n - from < COMPONENT_BLOCK ? n - from : COMPONENT_BLOCK;
+		const int *z = tz ? load_posixct_days(pr, from, len, buf, tz) : load_days(pi, pr, from, len, buf);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		if (p[DATE_YEAR])
+			memcpy(p[DATE_YEAR] + from, year, len * sizeof(int));
+		if (p[DATE_MONTH])
+			memcpy(p[DATE_MONTH] + from, month, len * sizeof(int));
+		if (p[DATE_DAY])
+			memcpy(p[DATE_DAY] + from, day, len * sizeof(int));
+
+		if (!extra)
+			continue;
+
+		for (R_xlen_t i = 0; i < len; i++) {
+			const R_xlen_t j = from + i;
+			if (z[i] == NA_INTEGER) {
+				for (int c = DATE_WDAY; c < N_DATE_COMPONENTS; c++)
+					if (p[c])
+						p[c][j] = NA_INTEGER;
+				continue;
+			}
+
+			const int wday = iso_wday(z[i]);
+			const int yday = month_start_days[ISLEAP(year[i])][month[i] - 1] + day[i];
+			if (p[DATE_WDAY])
+				p[DATE_WDAY][j] = wday;
+			if (p[DATE_YDAY])
+				p[DATE_YDAY][j] = yday;
+			if (iso) {
+				int week, iso_year;
+				iso_week(year[i], yday, wday, &week, &iso_year);
+				if (p[DATE_ISOWEEK])
+					p[DATE_ISOWEEK][j] = week;
+				if (p[DATE_ISOYEAR])
+					p[DATE_ISOYEAR][j] = iso_year;
+			}
+		}
+	}
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+
+	UNPROTECT(2);
+	return out;
+}
+
+SEXP get_components(SEXP x, SEXP components)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	return compute_components(pi, pr, XLENGTH(x), components, NULL);
+}
+
+/* times and offsets are the time zone table described in posixct.h */
+SEXP get_components_posixct(SEXP x, SEXP components, SEXP times, SEXP offsets)
+{
+	if (!Rf_inherits(x, "POSIXct") || TYPEOF(x) != REALSXP)
+		Rf_error("Input `x` must be a double <POSIXct> object.");
+	if (TYPEOF(times) != REALSXP || TYPEOF(offsets) != REALSXP || XLENGTH(times) != XLENGTH(offsets) || XLENGTH(times) == 0)
+		Rf_error("`times` and `offsets` must be non-empty double vectors of the same length.");
+
+	const struct tz_table tz = {REAL_RO(times), REAL_RO(offsets), LENGTH(times)};
+	return compute_components(NULL, REAL_RO(x), XLENGTH(x), components, &tz);
+}
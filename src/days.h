@@ -0,0 +1,64 @@
+#ifndef FASTYMD_DAYS_H
+#define FASTYMD_DAYS_H
+
+#include "civil_from_days.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Day numbers of integer or double Dates read in place. Doubles are floored
+ * and mapped to NA exactly as Rf_coerceVector() would (NaN and values outside
+ * the integer range) so both give identical results without a copy.
+ */
+
+static inline int day_at(const int *pi, const double *pr, R_xlen_t i)
+{
+	if (pi)
+		return pi[i];
+	double v = floor(pr[i]);
+	return (ISNAN(v) || v >= INT_MAX + 1. || v <= INT_MIN) ? NA_INTEGER : (int) v;
+}
+
+/* days for the block [from, from + len), using buf for doubles */
+static inline const int *load_days(const int *pi, const double *pr, R_xlen_t from, R_xlen_t len, int *buf)
+{
+	if (pi)
+		return pi + from;
+	for (R_xlen_t i = 0; i < len; i++)
+		buf[i] = day_at(pi, pr, from + i);
+	return buf;
+}
+
+/* whether any (non-NaN) double of the block [from, from + len) was outside the integer range */
+static inline bool days_coerced(const double *pr, R_xlen_t from, R_xlen_t len, const int *z)
+{
+	bool coerce = false;
+	if (pr) {
+		for (R_xlen_t i = 0; i < len; i++)
+			coerce |= z[i] == NA_INTEGER && !ISNAN(pr[from + i]);
+	}
+	return coerce;
+}
+
+/* the fastymd.sorted option: TRUE, FALSE or NA (probe each block) */
+static inline int sorted_option(void)
+{
+	return Rf_asLogical(Rf_GetOption1(Rf_install("fastymd.sorted")));
+}
+
+/* decompose a block with the incremental kernel if it is (or looks) sorted */
+static inline void civil_from_days_block(const int *z, R_xlen_t len, int *year, int *month, int *day, int sorted)
+{
+	if (sorted == TRUE || (sorted == NA_LOGICAL && is_sorted_run(z, len)))
+		civil_from_days_sorted_n(z, len, year, month, day);
+	else
+		civil_from_days_n(z, len, year, month, day);
+}
+
+#endif
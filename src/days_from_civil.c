@@ -44,6 +44,8 @@
 
 #include "days_from_civil.h"
 
+#include <stdint.h>
+
 int days_from_civil(int y, unsigned m, unsigned d)
 {
 	y -= m <= 2;
@@ -53,3 +55,38 @@ int days_from_civil(int y, unsigned m, unsigned d)
 	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;           // [0, 146096]
 	return era * 146097 + (int)(doe) - 719468;
 }
+
+/*
+ * Neri and Schneider (2023) "Euclidean affine functions and their application
+ * to calendar algorithms", Softw Pract Exper 53(4):937-970,
+ * https://doi.org/10.1002/spe.3172. Years are shifted forward by a multiple of
+ * 400 so the calculation is carried out in unsigned 32-bit arithmetic with
+ * divisions by constants only.
+ */
+#define NERI_SHIFT 82 /* 400 year cycles, valid for years >= -32800 */
+
+int days_from_civil_neri(int y, unsigned m, unsigned d)
+{
+	const uint32_t j = m <= 2;
+	const uint32_t yy = (uint32_t) (y + 400 * NERI_SHIFT) - j;
+	const uint32_t mm = j ? m + 12 : m;
+	const uint32_t c = yy / 100;
+	const uint32_t y_star = 1461 * yy / 4 - c + c / 4;
+	const uint32_t m_star = (979 * mm - 2919) / 32;
+	return (int) (y_star + m_star + d - 1 - (719468 + 146097u * NERI_SHIFT));
+}
+
+/* days since the epoch of the 1st January in each year of the table window */
+int year_start_days[CIVIL_TABLE_MAX_YEAR - CIVIL_TABLE_MIN_YEAR + 1];
+
+/* cumulative days before the start of each month for common and leap years */
+const int month_start_days[2][12] = {
+	{0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334},
+	{0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335}
+};
+
+void init_days_from_civil_table(void)
+{
+	for (int y = CIVIL_TABLE_MIN_YEAR; y <= CIVIL_TABLE_MAX_YEAR; y++)
+		year_start_days[y - CIVIL_TABLE_MIN_YEAR] = days_from_civil(y, 1, 1);
+}
@@ -1,6 +1,31 @@
 #ifndef FASTYMD_DAYS_FROM_CIVIL_H
 #define FASTYMD_DAYS_FROM_CIVIL_H
 
+#include "calendar.h"
+
 int days_from_civil(int y, unsigned m, unsigned d);
+int days_from_civil_neri(int y, unsigned m, unsigned d);
+
+/*
+ * Table driven days_from_civil() for years in [CIVIL_TABLE_MIN_YEAR,
+ * CIVIL_TABLE_MAX_YEAR] falling back to the arithmetic outside this window.
+ * Input must be a valid date and init_days_from_civil_table() must have been
+ * called.
+ */
+#define CIVIL_TABLE_MIN_YEAR 1900
+#define CIVIL_TABLE_MAX_YEAR 2100
+
+extern int year_start_days[CIVIL_TABLE_MAX_YEAR - CIVIL_TABLE_MIN_YEAR + 1];
+extern const int month_start_days[2][12];
+
+void init_days_from_civil_table(void);
+
+static inline int days_from_civil_fast(int y, unsigned m, unsigned d)
+{
+	if (y < CIVIL_TABLE_MIN_YEAR || y > CIVIL_TABLE_MAX_YEAR)
+		return days_from_civil(y, m, d);
+
+	return year_start_days[y - CIVIL_TABLE_MIN_YEAR] + month_start_days[ISLEAP(y)][m - 1] + (int) d - 1;
+}
 
 #endif
@@ -0,0 +1,66 @@
+#include "diagnostics.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* reported failure classes and their names */
+static const enum parse_status reported[] = {
+	PARSE_BAD_YEAR, PARSE_BAD_MONTH, PARSE_BAD_DAY, PARSE_TRAILING, PARSE_YEAR_RANGE
+};
+static const char *reported_names[] = {
+	"bad_year", "bad_month", "bad_day", "trailing", "out_of_range"
+};
+#define N_REPORTED (sizeof(reported) / sizeof(reported[0]))
+
+/* n zeroed records, e.g. one per thread (freed by R at the end of the .Call) */
+struct diagnostics *diagnostics_alloc(R_xlen_t n)
+{
+	struct diagnostics *diags = (struct diagnostics *) R_alloc((size_t) n, sizeof(struct diagnostics));
+	memset(diags, 0, (size_t) n * sizeof(struct diagnostics));
+	return diags;
+}
+
+static int compare_index(const void *a, const void *b)
+{
+	R_xlen_t x = *(const R_xlen_t *) a, y = *(const R_xlen_t *) b;
+	return (x > y) - (x < y);
+}
+
+/* attach list(counts = , indices = ) as the "diagnostics" attribute of x */
+void diagnostics_set(SEXP x, const struct diagnostics *diags, int nth)
+{
+	SEXP counts = PROTECT(Rf_allocVector(REALSXP, N_REPORTED));
+	SEXP names = PROTECT(Rf_allocVector(STRSXP, N_REPORTED));
+	for (size_t k = 0; k < N_REPORTED; k++) {
+		R_xlen_t total = 0;
+		for (int t = 0; t < nth; t++)
+			total += diags[t].counts[reported[k]];
+		REAL(counts)[k] = (double) total;
+		SET_STRING_ELT(names, k, Rf_mkChar(reported_names[k]));
+	}
+	Rf_namesgets(counts, names);
+
+	/* threads each hold the first indices of their own chunk */
+	int n = 0;
+	for (int t = 0; t < nth; t++)
+		n += diags[t].n_indices;
+	R_xlen_t *all = (R_xlen_t *) R_alloc(n + 1, sizeof(R_xlen_t));
+	for (int t = 0, k = 0; t < nth; t++)
+		for (int j = 0; j < diags[t].n_indices; j++)
+			all[k++] = diags[t].indices[j];
+	qsort(all, n, sizeof(R_xlen_t), compare_index);
+	n = n < DIAGNOSTIC_INDICES ? n : DIAGNOSTIC_INDICES;
+
+	/* 1-based for R */
+	SEXP indices = PROTECT(Rf_allocVector(REALSXP, n));
+	for (int k = 0; k < n; k++)
+		REAL(indices)[k] = (double) all[k] + 1;
+
+	const char *list_names[] = {"counts", "indices", ""};
+	SEXP out = PROTECT(Rf_mkNamed(VECSXP, list_names));
+	SET_VECTOR_ELT(out, 0, counts);
+	SET_VECTOR_ELT(out, 1, indices);
+	Rf_setAttrib(x, Rf_install("diagnostics"), out);
+
+	UNPROTECT(4);
+}
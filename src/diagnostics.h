@@ -0,0 +1,50 @@
+#ifndef FASTYMD_DIAGNOSTICS_H
+#define FASTYMD_DIAGNOSTICS_H
+
+#include "parse.h"
+
+#include <stdbool.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Optional record of the failures seen while parsing. Each thread keeps its
+ * own counts (by parse_status) along with the first few offending indices
+ * and these are combined in to an attribute once all threads have finished.
+ */
+
+#define DIAGNOSTIC_INDICES 100
+
+struct diagnostics {
+	R_xlen_t counts[PARSE_BAD_TIME + 1];
+	R_xlen_t indices[DIAGNOSTIC_INDICES];
+	int n_indices;
+};
+
+static inline void diagnostics_record(struct diagnostics *diag, enum parse_status status, R_xlen_t i)
+{
+	diag->counts[status]++;
+	if (diag->n_indices < DIAGNOSTIC_INDICES)
+		diag->indices[diag->n_indices++] = i;
+}
+
+/* note a failed element i, deferring any warning or error until after the loop */
+static inline void note_failure(enum parse_status status, R_xlen_t i, struct diagnostics *diag, bool range_na, bool *warn, bool *warn_range, R_xlen_t *bad)
+{
+	if (diag)
+		diagnostics_record(diag, status, i);
+
+	if (status != PARSE_YEAR_RANGE)
+		*warn = true;
+	else if (range_na)
+		*warn_range = true;
+	else if (i < *bad)
+		*bad = i;
+}
+
+struct diagnostics *diagnostics_alloc(R_xlen_t n);
+void diagnostics_set(SEXP x, const struct diagnostics *diags, int nth);
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef FASTYMD_EPOCHDAYS_H
 #define FASTYMD_EPOCHDAYS_H
 
+/* only valid for years >= JSONDEC_MIN_YEAR */
+#define JSONDEC_MIN_YEAR (-4799)
+
 int jsondec_epochdays(int y, int m, int d);
 
 #endif
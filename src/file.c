@@ -0,0 +1,374 @@
+#include "calendar.h"
+#include "kernel.h"
+#include "parse.h"
+#include "threads.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <stdio.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Parsing of dates directly from a file.
+ *
+ * The file is memory mapped (read in full on Windows) and each line is parsed
+ * in place with parse_ymd() so no intermediate character vector is created.
+ * The buffer is split in to one block per thread, with each block starting at
+ * the beginning of a line. A first pass counts the lines in each block which
+ * gives the offset in to the output vector for the second, parsing, pass.
+ * The same record parsing is used on blocks read from a connection by
+ * ymd_lines().
+ */
+
+struct file_buffer {
+	const char *data;
+	size_t size;
+#ifdef _WIN32
+	char *alloc;
+#else
+	void *map;
+#endif
+};
+
+static void open_buffer(const char *path, struct file_buffer *buf)
+{
+	memset(buf, 0, sizeof(*buf));
+
+#ifdef _WIN32
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+		Rf_error("Unable to open file '%s'.", path);
+	/* long is 32 bits on Windows so use the 64 bit variants */
+	if (_fseeki64(f, 0, SEEK_END) != 0) {
+		fclose(f);
+		Rf_error("Unable to read file '%s'.", path);
+	}
+	__int64 size = _ftelli64(f);
+	rewind(f);
+	if (size > 0) {
+		buf->alloc = R_alloc((size_t) size, sizeof(char));
+		if (fread(buf->alloc, 1, (size_t) size, f) != (size_t) size) {
+			fclose(f);
+			Rf_error("Unable to read file '%s'.", path);
+		}
+	}
+	fclose(f);
+	buf->data = buf->alloc;
+	buf->size = size > 0 ? (size_t) size : 0;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		Rf_error("Unable to open file '%s'.", path);
+	struct stat st;
+	if (fstat(fd, &st) == -1) {
+		close(fd);
+		Rf_error("Unable to read file '%s'.", path);
+	}
+	buf->size = (size_t) st.st_size;
+	if (buf->size) {
+		buf->map = mmap(NULL, buf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buf->map == MAP_FAILED) {
+			close(fd);
+			Rf_error("Unable to map file '%s'.", path);
+		}
+		madvise(buf->map, buf->size, MADV_SEQUENTIAL);
+		buf->data = buf->map;
+	}
+	close(fd);
+#endif
+}
+
+static void close_buffer(struct file_buffer *buf)
+{
+#ifndef _WIN32
+	if (buf->map) {
+		munmap(buf->map, buf->size);
+		buf->map = NULL;
+	}
+#endif
+}
+
+/* close_buffer() as an R_ExecWithCleanup() cleanup function */
+static void release_buffer(void *data)
+{
+	close_buffer((struct file_buffer *) data);
+}
+
+/* start of the line after the one containing p (or end) */
+static inline const char* next_line(const char *p, const char *end)
+{
+	const char *nl = memchr(p, '\n', end - p);
+	return nl ? nl + 1 : end;
+}
+
+/*
+ * Locate field `column` (0 based) of the line [line, eol). Returns false if
+ * the line has too few fields. Surrounding double quotes are dropped.
+ */
+static inline bool find_field(const char *line, const char *eol, int column, char sep, const char **from, const char **to)
+{
+	const char *c = line;
+	for (int k = 0; k < column; k++) {
+		const char *s = memchr(c, sep, eol - c);
+		if (s == NULL)
+			return false;
+		c = s + 1;
+	}
+	const char *e = memchr(c, sep, eol - c);
+	if (e == NULL)
+		e = eol;
+
+	if (e - c >= 2 && *c == '"' && e[-1] == '"') {
+		c++;
+		e--;
+	}
+	*from = c;
+	*to = e;
+	return true;
+}
+
+/*
+ * Validated record options shared by ymd_file() and ymd_lines(). Every option
+ * is read here, before any file is opened, so that parsing cannot raise an
+ * error for a bad option.
+ */
+struct record_options {
+	int column; /* 0-based or -1 for a whole line per date */
+	char sep;
+	bool strict;
+	enum civil_kernel kernel;
+	int threads; /* thread_limit() */
+};
+
+static struct record_options as_record_options(SEXP column, SEXP sep, SEXP strict)
+{
+	if ((!IS_SCALAR(strict, LGLSXP)) || LOGICAL_RO(strict)[0] == NA_LOGICAL)
+		Rf_error("`strict` must be a bool.");
+
+	/* column is NULL for a whole line per date */
+	struct record_options opt = {-1, ',', LOGICAL_RO(strict)[0], civil_kernel_option(), thread_limit()};
+	if (column != R_NilValue) {
+		opt.column = Rf_asInteger(column);
+		if (opt.column == NA_INTEGER || opt.column < 1)
+			Rf_error("`column` must be a positive integer.");
+		opt.column--;
+		if (!IS_SCALAR(sep, STRSXP) || LENGTH(STRING_ELT(sep, 0)) != 1)
+			Rf_error("`sep` must be a single character.");
+		opt.sep = CHAR(STRING_ELT(sep, 0))[0];
+	}
+	return opt;
+}
+
+/*
+ * Parse the newline delimited records in [begin, end) in to a new (protected)
+ * integer vector. Errors are not raised here, so that callers can release
+ * resources first. Instead `bad` is set to the index of the first out of
+ * range year (or the number of records) and `warn` to whether any record was
+ * invalid.
+ */
+static SEXP parse_records(const char *begin, const char *end, struct record_options opt, R_xlen_t *bad, int *bad_year, bool *warn)
+{
+	/* split in to blocks that start at the beginning of a line */
+	int nth = (end - begin) / 16 < MIN_PARALLEL_SIZE ? 1 : opt.threads;
+	const char **blocks = (const char **) R_alloc(nth + 1, sizeof(const char *));
+	R_xlen_t *offsets = (R_xlen_t *) R_alloc(nth + 1, sizeof(R_xlen_t));
+	blocks[0] = begin;
+	for (int k = 1; k < nth; k++) {
+		const char *b = begin + (end - begin) / nth * k;
+		b = b > blocks[k - 1] ? b : blocks[k - 1];
+		blocks[k] = b == begin ? b : next_line(b - 1, end);
+	}
+	blocks[nth] = end;
+
+	/* count lines in each block (a final line need not end in a newline) */
+	offsets[0] = 0;
+	#pragma omp parallel for num_threads(nth) schedule(static)
+	for (int k = 0; k < nth; k++) {
+		R_xlen_t count = 0;
+		for (const char *p = blocks[k]; p < blocks[k + 1]; p = next_line(p, blocks[k + 1]))
+			count++;
+		offsets[k + 1] = count;
+	}
+	for (int k = 0; k < nth; k++)
+		offsets[k + 1] += offsets[k];
+
+	R_xlen_t size = offsets[nth];
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, size));
+	int* pout = INTEGER(out);
+
+	bool warn_ = false;
+	R_xlen_t bad_ = size;
+	int bad_year_ = 0;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn_)
+	for (int k = 0; k < nth; k++) {
+		R_xlen_t i = offsets[k];
+		const char *bend = blocks[k + 1];
+		for (const char *line = blocks[k]; line < bend; i++) {
+			const char *next = next_line(line, bend);
+			const char *eol = next > line && next[-1] == '\n' ? next - 1 : next;
+			const char *from = line, *to = eol;
+
+			/* drop a trailing carriage return */
+			if (to > from && to[-1] == '\r')
+				to--;
+			line = next;
+
+			if (opt.column >= 0 && !find_field(from, to, opt.column, opt.sep, &from, &to)) {
+				pout[i] = NA_INTEGER;
+				warn_ = true;
+				continue;
+			}
+
+			/* missing values are written as NA */
+			if (to - from == 2 && from[0] == 'N' && from[1] == 'A') {
+				pout[i] = NA_INTEGER;
+				continue;
+			}
+
+			int value;
+			switch (parse_ymd(from, to, opt.strict, opt.kernel, &value)) {
+			case PARSE_OK:
+				pout[i] = value;
+				break;
+			case PARSE_YEAR_RANGE:
+				pout[i] = NA_INTEGER;
+				#pragma omp critical
+				if (i < bad_) {
+					bad_ = i;
+					bad_year_ = value;
+				}
+				break;
+			default:
+				pout[i] = NA_INTEGER;
+				warn_ = true;
+				break;
+			}
+		}
+	}
+
+	*bad = bad_;
+	*bad_year = bad_year_;
+	*warn = warn_;
+	return out;
+}
+
+/* parse_records() for R_ExecWithCleanup(), returning an unprotected vector */
+struct parse_call {
+	const char *begin;
+	const char *end;
+	struct record_options opt;
+	R_xlen_t bad;
+	int bad_year;
+	bool warn;
+};
+
+static SEXP parse_records_call(void *data)
+{
+	struct parse_call *call = (struct parse_call *) data;
+	SEXP out = parse_records(call->begin, call->end, call->opt, &call->bad, &call->bad_year, &call->warn);
+	UNPROTECT(1);
+	return out;
+}
+
+SEXP ymd_file(SEXP path, SEXP column, SEXP sep, SEXP skip, SEXP strict)
+{
+	if (!IS_SCALAR(path, STRSXP) || STRING_ELT(path, 0) == NA_STRING)
+		Rf_error("`path` must be a string.");
+
+	struct record_options opt = as_record_options(column, sep, strict);
+
+	int skip_ = Rf_asInteger(skip);
+	if (skip_ == NA_INTEGER || skip_ < 0)
+		Rf_error("`skip` must be a non-negative integer.");
+
+	struct file_buffer buf;
+	open_buffer(R_ExpandFileName(CHAR(STRING_ELT(path, 0))), &buf);
+	const char *begin = buf.data;
+	const char *end = buf.data + buf.size;
+
+	/* skip any header lines */
+	for (int k = 0; k < skip_ && begin < end; k++)
+		begin = next_line(begin, end);
+
+	/*
+	 * The file is closed even if parsing is interrupted by an error (e.g. on
+	 * allocation) and errors and warnings are raised once it is closed.
+	 */
+	struct parse_call call = {begin, end, opt, 0, 0, false};
+	SEXP out = PROTECT(R_ExecWithCleanup(parse_records_call, &call, release_buffer, &buf));
+
+	if (call.bad < XLENGTH(out))
+		Rf_error("Years must be in the range [%d, %d]. Line %td has year %d.", -MAX_YEAR, MAX_YEAR, call.bad + skip_ + 1, call.bad_year);
+
+	if (call.warn)
+		Rf_warning("NAs introduced due to invalid date strings.");
+
+	/* set class to "Date" */
+	Rf_classgets(out, Rf_mkString("Date"));
+
+	UNPROTECT(1);
+	return out;
+}
+
+/*
+ * Parse the complete records in the raw buffer `x`, a block read from a
+ * connection by fymd_stream(). Unless `final`, bytes after the last newline
+ * are a partial record which is left for the next block. `line` is the number
+ * of lines before the buffer (for error messages). Returns the dates along
+ * with the number of bytes consumed.
+ */
+SEXP ymd_lines(SEXP x, SEXP final, SEXP column, SEXP sep, SEXP strict, SEXP line)
+{
+	if (TYPEOF(x) != RAWSXP)
+		Rf_error("`x` must be a raw vector.");
+	if ((!IS_SCALAR(final, LGLSXP)) || LOGICAL_RO(final)[0] == NA_LOGICAL)
+		Rf_error("`final` must be a bool.");
+
+	struct record_options opt = as_record_options(column, sep, strict);
+
+	double line_ = Rf_asReal(line);
+	if (ISNAN(line_) || line_ < 0)
+		Rf_error("`line` must be a non-negative number.");
+
+	const char *begin = (const char *) RAW_RO(x);
+	const char *end = begin + XLENGTH(x);
+
+	/* hold back a trailing partial record */
+	if (!LOGICAL_RO(final)[0]) {
+		while (end > begin && end[-1] != '\n')
+			end--;
+	}
+
+	R_xlen_t bad;
+	int bad_year;
+	bool warn;
+	SEXP dates = parse_records(begin, end, opt, &bad, &bad_year, &warn);
+
+	if (bad < XLENGTH(dates))
+		Rf_error("Years must be in the range [%d, %d]. Line %.0f has year %d.", -MAX_YEAR, MAX_YEAR, line_ + bad + 1, bad_year);
+
+	if (warn)
+		Rf_warning("NAs introduced due to invalid date strings.");
+
+	Rf_classgets(dates, Rf_mkString("Date"));
+
+	const char *names[] = {"dates", "consumed", ""};
+	SEXP out = PROTECT(Rf_mkNamed(VECSXP, names));
+	SET_VECTOR_ELT(out, 0, dates);
+	SET_VECTOR_ELT(out, 1, Rf_ScalarReal((double) (end - begin)));
+
+	UNPROTECT(2);
+	return out;
+}
@@ -0,0 +1,176 @@
+#include "calendar.h"
+#include "civil_from_days.h"
+#include "days.h"
+#include "threads.h"
+
+#include <limits.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Formatting of Dates as year-month-day strings.
+ *
+ * Digits are written directly in to a stack buffer. Dates tend to repeat so
+ * we keep a small direct mapped cache from day number to CHARSXP meaning that
+ * Rf_mkCharLenCE() is, typically, only called once per distinct date. Entries
+ * are only ever taken from the output vector so they are always protected.
+ */
+
+#define FORMAT_CACHE_BITS 12
+#define FORMAT_CACHE_MASK ((1 << FORMAT_CACHE_BITS) - 1)
+
+/* write n (>= 0) with at least `width` digits, returning the number written */
+static inline int write_digits(char *buf, unsigned n, int width)
+{
+	char tmp[16];
+	int len = 0;
+	do {
+		tmp[len++] = (char)('0' + n % 10);
+		n /= 10;
+	} while (n);
+	while (len < width)
+		tmp[len++] = '0';
+	for (int k = 0; k < len; k++)
+		buf[k] = tmp[len - 1 - k];
+	return len;
+}
+
+static inline int format_day(char *buf, int value, const char *sep, int seplen)
+{
+	int year, month, day;
+	civil_from_days(value, &year, &month, &day);
+
+	int len = 0;
+	if (year < 0)
+		buf[len++] = '-';
+	len += write_digits(buf + len, year < 0 ? -(unsigned) year : (unsigned) year, 4);
+	memcpy(buf + len, sep, seplen);
+	len += seplen;
+	buf[len++] = (char)('0' + month / 10);
+	buf[len++] = (char)('0' + month % 10);
+	memcpy(buf + len, sep, seplen);
+	len += seplen;
+	buf[len++] = (char)('0' + day / 10);
+	buf[len++] = (char)('0' + day % 10);
+	return len;
+}
+
+SEXP format_ymd(SEXP x, SEXP sep)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+	if (!IS_SCALAR(sep, STRSXP) || STRING_ELT(sep, 0) == NA_STRING)
+		Rf_error("`sep` must be a string.");
+
+	const char *sep_ = CHAR(STRING_ELT(sep, 0));
+	int seplen = LENGTH(STRING_ELT(sep, 0));
+	if (seplen > 16)
+		Rf_error("`sep` must be at most 16 bytes.");
+	cetype_t enc = Rf_getCharCE(STRING_ELT(sep, 0));
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	R_xlen_t n = XLENGTH(x);
+	SEXP out = PROTECT(Rf_allocVector(STRSXP, n));
+
+	struct {
+		int value;
+		SEXP chr;
+	} cache[FORMAT_CACHE_MASK + 1];
+	for (int k = 0; k <= FORMAT_CACHE_MASK; k++)
+		cache[k].chr = NULL;
+
+	char buf[64];
+	for (R_xlen_t i = 0; i < n; i++) {
+		int value;
+		if (pi) {
+			value = pi[i];
+		} else {
+			double v = pr[i];
+			value = (ISNAN(v) || v >= INT_MAX + 1. || v <= INT_MIN) ? NA_INTEGER : (int) floor(v);
+		}
+
+		if (value == NA_INTEGER) {
+			SET_STRING_ELT(out, i, NA_STRING);
+			continue;
+		}
+
+		int slot = value & FORMAT_CACHE_MASK;
+		if (cache[slot].chr == NULL || cache[slot].value != value) {
+			int len = format_day(buf, value, sep_, seplen);
+			cache[slot].value = value;
+			cache[slot].chr = Rf_mkCharLenCE(buf, len, enc);
+		}
+		SET_STRING_ELT(out, i, cache[slot].chr);
+	}
+
+	Rf_namesgets(out, Rf_getAttrib(x, R_NamesSymbol));
+
+	UNPROTECT(1);
+	return out;
+}
+
+/* Days are decomposed in blocks of this size for to_yyyymmdd(). */
+#define YYYYMMDD_BLOCK 1024
+
+/*
+ * Dates as integer codes year * 10000 + month * 100 + day, negated for
+ * negative years. Years outside [-MAX_YEAR, MAX_YEAR] do not fit the layout
+ * and give NA with a warning.
+ */
+SEXP to_yyyymmdd(SEXP x)
+{
+	if (!Rf_inherits(x, "Date"))
+		Rf_error("Input `x` must be a <Date> object.");
+
+	const int *pi = TYPEOF(x) == INTSXP ? INTEGER_RO(x) : NULL;
+	const double *pr = TYPEOF(x) == REALSXP ? REAL_RO(x) : NULL;
+	if (pi == NULL && pr == NULL)
+		Rf_error("Input `x` must be a numeric <Date> object.");
+
+	R_xlen_t n = XLENGTH(x);
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, n));
+	int *pout = INTEGER(out);
+
+	int nth = num_threads(n);
+	(void) nth;
+	const int sorted = sorted_option();
+	bool coerce = false, range = false;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:coerce) reduction(||:range)
+	for (R_xlen_t from = 0; from < n; from += YYYYMMDD_BLOCK) {
+		int buf[YYYYMMDD_BLOCK], year[YYYYMMDD_BLOCK], month[YYYYMMDD_BLOCK], day[YYYYMMDD_BLOCK];
+		R_xlen_t len = n - from < YYYYMMDD_BLOCK ? n - from : YYYYMMDD_BLOCK;
+		const int *z = load_days(pi, pr, from, len, buf);
+		coerce |= days_coerced(pr, from, len, z);
+		civil_from_days_block(z, len, year, month, day, sorted);
+
+		/* unsigned arithmetic and selects only so the loop can vectorise */
+		int *o = pout + from;
+		for (R_xlen_t i = 0; i < len; i++) {
+			const int y = year[i];
+			const unsigned a = y < 0 ? -(unsigned) y : (unsigned) y;
+			const unsigned code = a * 10000u + (unsigned) month[i] * 100u + (unsigned) day[i];
+			const bool na = z[i] == NA_INTEGER;
+			const bool out_of_range = a > MAX_YEAR && !na;
+			range |= out_of_range;
+			o[i] = (na || out_of_range) ? NA_INTEGER : (int) (y < 0 ? -code : code);
+		}
+	}
+
+	if (coerce)
+		Rf_warning("NAs introduced by coercion to integer range");
+	if (range)
+		Rf_warning("NAs introduced due to years outside the range [%d, %d].", -MAX_YEAR, MAX_YEAR);
+
+	Rf_namesgets(out, Rf_getAttrib(x, R_NamesSymbol));
+
+	UNPROTECT(1);
+	return out;
+}
@@ -3,23 +3,60 @@
 #include <stdlib.h> // for NULL
 #include <R_ext/Rdynload.h>
 
+#include "altrep.h"
+#include "callable.h"
+#include "civil_from_days.h"
+#include "days_from_civil.h"
+
 /* .Call calls */
-extern SEXP ymd(SEXP, SEXP, SEXP);
-extern SEXP ymd_character(SEXP, SEXP);
+extern SEXP ymd(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_character(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_yyyymmdd(SEXP, SEXP, SEXP);
+extern SEXP ymd_columns(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_hms_character(SEXP, SEXP);
 extern SEXP is_leap_year(SEXP);
 extern SEXP get_ymd(SEXP);
 extern SEXP get_year(SEXP);
 extern SEXP get_month(SEXP);
 extern SEXP get_mday(SEXP);
+extern SEXP get_components(SEXP, SEXP);
+extern SEXP get_components_posixct(SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_file(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_lines(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_raw(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP ymd_raw_offsets(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP format_ymd(SEXP, SEXP);
+extern SEXP to_yyyymmdd(SEXP);
+extern SEXP floor_ymd(SEXP, SEXP);
+extern SEXP ceiling_ymd(SEXP, SEXP);
+extern SEXP add_months(SEXP, SEXP, SEXP);
+extern SEXP period_key(SEXP, SEXP, SEXP);
+extern SEXP count_by_period(SEXP, SEXP);
 
 static const R_CallMethodDef CallEntries[] = {
-    {"ymd",           (DL_FUNC) &ymd,           3},
-    {"ymd_character", (DL_FUNC) &ymd_character, 2},
+    {"ymd",           (DL_FUNC) &ymd,           5},
+    {"ymd_character", (DL_FUNC) &ymd_character, 5},
+    {"ymd_yyyymmdd",  (DL_FUNC) &ymd_yyyymmdd,  3},
+    {"ymd_columns",   (DL_FUNC) &ymd_columns,   5},
+    {"ymd_hms_character", (DL_FUNC) &ymd_hms_character, 2},
     {"is_leap_year",  (DL_FUNC) &is_leap_year,  1},
     {"get_ymd",       (DL_FUNC) &get_ymd,       1},
     {"get_year",      (DL_FUNC) &get_year,      1},
     {"get_month",     (DL_FUNC) &get_month,     1},
     {"get_mday",      (DL_FUNC) &get_mday,       1},
+    {"get_components", (DL_FUNC) &get_components, 2},
+    {"get_components_posixct", (DL_FUNC) &get_components_posixct, 4},
+    {"ymd_file",      (DL_FUNC) &ymd_file,      5},
+    {"ymd_lines",     (DL_FUNC) &ymd_lines,     6},
+    {"ymd_raw",       (DL_FUNC) &ymd_raw,       7},
+    {"ymd_raw_offsets", (DL_FUNC) &ymd_raw_offsets, 5},
+    {"format_ymd",    (DL_FUNC) &format_ymd,    2},
+    {"to_yyyymmdd",   (DL_FUNC) &to_yyyymmdd,   1},
+    {"floor_ymd",     (DL_FUNC) &floor_ymd,     2},
+    {"ceiling_ymd",   (DL_FUNC) &ceiling_ymd,   2},
+    {"add_months",    (DL_FUNC) &add_months,    3},
+    {"period_key",    (DL_FUNC) &period_key,    3},
+    {"count_by_period", (DL_FUNC) &count_by_period, 2},
     {NULL,                           NULL,      0}
 };
 
@@ -28,5 +65,9 @@ void R_init_fastymd(DllInfo *dll)
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
     R_forceSymbols(dll, TRUE);
+    init_lazy_components(dll);
+    init_civil_from_days_table();
+    init_days_from_civil_table();
+    init_callables();
 }
 
@@ -0,0 +1,32 @@
+#include "kernel.h"
+
+#include <string.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+const char *const civil_kernel_names[KERNEL_COUNT] = {"table", "hinnant", "jsondec", "neri"};
+
+_Static_assert(FASTYMD_KERNEL >= 0 && FASTYMD_KERNEL < KERNEL_COUNT, "FASTYMD_KERNEL must name a civil_kernel");
+
+/*
+ * The kernel for the current call from the `fastymd.kernel` option. NULL
+ * selects the build time default, FASTYMD_KERNEL.
+ */
+enum civil_kernel civil_kernel_option(void)
+{
+	SEXP opt = Rf_GetOption1(Rf_install("fastymd.kernel"));
+	if (Rf_isNull(opt))
+		return FASTYMD_KERNEL;
+
+	if (TYPEOF(opt) == STRSXP && XLENGTH(opt) == 1 && STRING_ELT(opt, 0) != NA_STRING) {
+		const char *name = CHAR(STRING_ELT(opt, 0));
+		for (int k = 0; k < KERNEL_COUNT; k++) {
+			if (strcmp(name, civil_kernel_names[k]) == 0)
+				return (enum civil_kernel) k;
+		}
+	}
+
+	Rf_error("Option `fastymd.kernel` must be one of \"table\", \"hinnant\", \"jsondec\" or \"neri\".");
+}
@@ -0,0 +1,49 @@
+#ifndef FASTYMD_KERNEL_H
+#define FASTYMD_KERNEL_H
+
+#include "days_from_civil.h"
+#include "epochdays.h"
+
+/*
+ * Interchangeable implementations of days_from_civil() used by the parsers and
+ * ymd(). All give identical results for valid dates in [-MAX_YEAR, MAX_YEAR].
+ * The kernel is read once per call by civil_kernel_option() and passed down by
+ * value so it is loop invariant in the callers.
+ */
+enum civil_kernel {
+	KERNEL_TABLE,
+	KERNEL_HINNANT,
+	KERNEL_JSONDEC,
+	KERNEL_NERI,
+	KERNEL_COUNT
+};
+
+extern const char *const civil_kernel_names[KERNEL_COUNT];
+
+/*
+ * The kernel used when `fastymd.kernel` is unset. It is fixed when the package
+ * is built (e.g. -DFASTYMD_KERNEL=KERNEL_NERI in PKG_CPPFLAGS) so a given build
+ * always gives the same choice on every machine.
+ */
+#ifndef FASTYMD_KERNEL
+#define FASTYMD_KERNEL KERNEL_TABLE
+#endif
+
+enum civil_kernel civil_kernel_option(void);
+
+/* Input must be a valid date. */
+static inline int days_from_civil_kernel(enum civil_kernel kernel, int y, unsigned m, unsigned d)
+{
+	switch (kernel) {
+	case KERNEL_HINNANT:
+		return days_from_civil(y, m, d);
+	case KERNEL_JSONDEC:
+		return y < JSONDEC_MIN_YEAR ? days_from_civil(y, m, d) : jsondec_epochdays(y, (int) m, (int) d);
+	case KERNEL_NERI:
+		return days_from_civil_neri(y, m, d);
+	default:
+		return days_from_civil_fast(y, m, d);
+	}
+}
+
+#endif
@@ -0,0 +1,443 @@
+#include "parse.h"
+#include "calendar.h"
+#include "kernel.h"
+
+#include <stddef.h>
+
+/*
+ * Fixed-width parse of a 10 byte "YYYY-MM-DD" string (any non-digit separator).
+ * All digits and separators are checked with straight-line arithmetic and a
+ * single branch at the end so the compiler can vectorise the whole check.
+ * Returns false if the layout does not match in which case the caller should
+ * fall back to the general parser.
+ */
+static inline bool fixed_width_ymd(const char *c, int *year, int *month, int *day)
+{
+	const unsigned char *s = (const unsigned char *) c;
+
+	const unsigned y0 = s[0] - '0', y1 = s[1] - '0', y2 = s[2] - '0', y3 = s[3] - '0';
+	const unsigned m0 = s[5] - '0', m1 = s[6] - '0';
+	const unsigned d0 = s[8] - '0', d1 = s[9] - '0';
+
+	/* digits in [0, 9] and separators that are not digits */
+	const unsigned bad = (y0 > 9) | (y1 > 9) | (y2 > 9) | (y3 > 9)
+		| (m0 > 9) | (m1 > 9) | (d0 > 9) | (d1 > 9)
+		| ISDIGIT(s[4]) | ISDIGIT(s[7]);
+	if (bad)
+		return false;
+
+	*year  = (int)(y0 * 1000 + y1 * 100 + y2 * 10 + y3);
+	*month = (int)(m0 * 10 + m1);
+	*day   = (int)(d0 * 10 + d1);
+	return true;
+}
+
+/* skip trailing whitespace and, if strict, reject anything else */
+static inline enum parse_status finish(const char *c, const char *end, bool strict)
+{
+	while (c < end && ISSPACE(*c))
+		c++;
+
+	return strict && c != end ? PARSE_TRAILING : PARSE_OK;
+}
+
+/*
+ * Scan the date at the start of [*cp, end) leaving *cp just past the day. The
+ * caller decides what is allowed to follow. Status and `value` are as for
+ * parse_ymd().
+ */
+static inline enum parse_status scan_ymd(const char **cp, const char *end, enum civil_kernel kernel, int *value)
+{
+	const char *c = *cp;
+
+	/* fast path for canonical "YYYY-MM-DD" input (possibly followed by a time) */
+	int year, month, day;
+	if (end - c >= 10 && (end - c == 10 || !ISDIGIT(c[10])) && fixed_width_ymd(c, &year, &month, &day)) {
+		if (month < 1 || month > 12)
+			return PARSE_BAD_MONTH;
+		if (day < 1 || day > days_in_month(year, month))
+			return PARSE_BAD_DAY;
+		*cp = c + 10;
+		*value = days_from_civil_kernel(kernel, year, month, day);
+		return PARSE_OK;
+	}
+
+	/* skip leading whitespace */
+	while(c < end && ISSPACE(*c))
+		c++;
+
+	/* handle negatives */
+	bool negative = false;
+	if (c < end && *c == '-') {
+		negative = true;
+		c++;
+	}
+
+	if (c == end || !ISDIGIT(*c))
+		return PARSE_BAD_YEAR;
+
+	/* Otherwise, string starts (correctly) with digit */
+
+	/* handle the year with arbitrary MAXIMUM */
+	year = 0;
+	while (c < end && ISDIGIT(*c)) {
+		year = year * 10 + (*c - '0');
+		if (year > MAX_YEAR) {
+			*value = negative ? -year : year;
+			return PARSE_YEAR_RANGE;
+		}
+		c++;
+	}
+	if (negative)
+		year= -year;
+
+	/* skip non-digit values */
+	while (c < end && !ISDIGIT(*c))
+		c++;
+
+	/* handle the month */
+	month = 0;
+	while (c < end && ISDIGIT(*c)) {
+		month = month * 10 + (*c - '0');
+		if (month > 12)
+			return PARSE_BAD_MONTH;
+		c++;
+	}
+	if (month ==  0)
+		return PARSE_BAD_MONTH;
+
+	/* skip non-digit values */
+	while (c < end && !ISDIGIT(*c))
+		c++;
+
+	/* handle the day */
+	int daysinmonth = days_in_month(year, month);
+	day = 0;
+	while (c < end && ISDIGIT(*c)) {
+		day = day * 10 + (*c - '0');
+		if (day > daysinmonth)
+			return PARSE_BAD_DAY;
+		c++;
+	}
+	if (day ==  0)
+		return PARSE_BAD_DAY;
+
+	*cp = c;
+	*value = days_from_civil_kernel(kernel, year, month, day);
+	return PARSE_OK;
+}
+
+/*
+ * Parse the date in [c, end). Digits are read in a fixed year, month and day
+ * order and can be separated by any non-digit characters. On success `value`
+ * is set to the days since the epoch. If the year is out of range `value` is
+ * set to the offending year so it can be reported.
+ */
+enum parse_status parse_ymd(const char *c, const char *end, bool strict, enum civil_kernel kernel, int *value)
+{
+	enum parse_status status = scan_ymd(&c, end, kernel, value);
+	if (status != PARSE_OK)
+		return status;
+
+	return finish(c, end, strict);
+}
+
+/*
+ * Parsers for the other formats. Day-month-year and month-day-year orders
+ * are generated from a single scanner whose field order is a compile-time
+ * constant, so each gets its own specialised fixed-width fast path and
+ * general path. Compact "YYYYMMDD" and ordinal "YYYY-DDD" dates have
+ * dedicated kernels. All share the validation of check_ymd().
+ */
+enum field { FIELD_YEAR, FIELD_MONTH, FIELD_DAY };
+
+#define FIELD_WIDTH(f) ((f) == FIELD_YEAR ? 4 : 2)
+#define FIELD_MAX(f) ((f) == FIELD_YEAR ? MAX_YEAR : (f) == FIELD_MONTH ? 12 : 31)
+#define FIELD_STATUS(f) ((f) == FIELD_YEAR ? PARSE_BAD_YEAR : (f) == FIELD_MONTH ? PARSE_BAD_MONTH : PARSE_BAD_DAY)
+
+static inline enum parse_status scan_fields(const char **cp, const char *end, const enum field order[3], enum civil_kernel kernel, int *value)
+{
+	const char *c = *cp;
+	int v[3] = {0, 0, 0}; /* indexed by field */
+
+	/* fast path for canonical fixed-width input, e.g. "DD/MM/YYYY" */
+	if (end - c >= 10 && (end - c == 10 || !ISDIGIT(c[10]))) {
+		const unsigned char *s = (const unsigned char *) c;
+		unsigned bad = 0;
+		for (int k = 0; k < 3; k++) {
+			for (int j = 0; j < FIELD_WIDTH(order[k]); j++, s++) {
+				bad |= (unsigned) (*s - '0') > 9;
+				v[order[k]] = v[order[k]] * 10 + (*s - '0');
+			}
+			if (k < 2)
+				bad |= ISDIGIT(*s++);
+		}
+		if (!bad) {
+			enum parse_status status = check_ymd(v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+			if (status != PARSE_OK)
+				return status;
+			*cp = c + 10;
+			*value = days_from_civil_kernel(kernel, v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+			return PARSE_OK;
+		}
+		v[0] = v[1] = v[2] = 0;
+	}
+
+	/* skip leading whitespace */
+	while (c < end && ISSPACE(*c))
+		c++;
+
+	/* negative years only when the year comes first */
+	bool negative = false;
+	if (order[0] == FIELD_YEAR && c < end && *c == '-') {
+		negative = true;
+		c++;
+	}
+
+	/* digits separated by non-digits */
+	for (int k = 0; k < 3; k++) {
+		const enum field f = order[k];
+		if (k > 0) {
+			while (c < end && !ISDIGIT(*c))
+				c++;
+		}
+		if (c == end || !ISDIGIT(*c))
+			return FIELD_STATUS(f);
+		while (c < end && ISDIGIT(*c)) {
+			v[f] = v[f] * 10 + (*c - '0');
+			if (v[f] > FIELD_MAX(f)) {
+				if (f != FIELD_YEAR)
+					return FIELD_STATUS(f);
+				*value = negative ? -v[f] : v[f];
+				return PARSE_YEAR_RANGE;
+			}
+			c++;
+		}
+	}
+	if (negative)
+		v[FIELD_YEAR] = -v[FIELD_YEAR];
+
+	enum parse_status status = check_ymd(v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+	if (status != PARSE_OK)
+		return status;
+
+	*cp = c;
+	*value = days_from_civil_kernel(kernel, v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+	return PARSE_OK;
+}
+
+#define DEFINE_FIELD_PARSER(name, f0, f1, f2)                                          \
+	static enum parse_status name(const char *c, const char *end, bool strict,         \
+	                              enum civil_kernel kernel, int *value)                \
+	{                                                                                  \
+		static const enum field order[3] = {f0, f1, f2};                               \
+		enum parse_status status = scan_fields(&c, end, order, kernel, value);         \
+		return status == PARSE_OK ? finish(c, end, strict) : status;                   \
+	}
+
+DEFINE_FIELD_PARSER(parse_dmy, FIELD_DAY, FIELD_MONTH, FIELD_YEAR)
+DEFINE_FIELD_PARSER(parse_mdy, FIELD_MONTH, FIELD_DAY, FIELD_YEAR)
+
+/* exactly eight digits, "YYYYMMDD" */
+static enum parse_status parse_compact(const char *c, const char *end, bool strict, enum civil_kernel kernel, int *value)
+{
+	static const enum field order[3] = {FIELD_YEAR, FIELD_MONTH, FIELD_DAY};
+
+	/* skip leading whitespace */
+	while (c < end && ISSPACE(*c))
+		c++;
+
+	int v[3] = {0, 0, 0};
+	for (int k = 0; k < 3; k++) {
+		for (int j = 0; j < FIELD_WIDTH(order[k]); j++, c++) {
+			if (c == end || !ISDIGIT(*c))
+				return FIELD_STATUS(order[k]);
+			v[order[k]] = v[order[k]] * 10 + (*c - '0');
+		}
+	}
+
+	/* a longer run of digits is not a compact date */
+	if (c < end && ISDIGIT(*c))
+		return PARSE_BAD_DAY;
+
+	enum parse_status status = check_ymd(v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+	if (status != PARSE_OK)
+		return status;
+
+	*value = days_from_civil_kernel(kernel, v[FIELD_YEAR], v[FIELD_MONTH], v[FIELD_DAY]);
+	return finish(c, end, strict);
+}
+
+/* ordinal dates, year then day of the year, e.g. "2025-106" or "2025106" */
+static enum parse_status parse_yday(const char *c, const char *end, bool strict, enum civil_kernel kernel, int *value)
+{
+	/* skip leading whitespace */
+	while (c < end && ISSPACE(*c))
+		c++;
+
+	int year = 0, yday = 0;
+	if (end - c >= 7 && (end - c == 7 || !ISDIGIT(c[7]))
+	    && ISDIGIT(c[0]) && ISDIGIT(c[1]) && ISDIGIT(c[2]) && ISDIGIT(c[3])
+	    && ISDIGIT(c[4]) && ISDIGIT(c[5]) && ISDIGIT(c[6])) {
+
+		/* compact "YYYYDDD" */
+		year = (c[0] - '0') * 1000 + (c[1] - '0') * 100 + (c[2] - '0') * 10 + (c[3] - '0');
+		yday = (c[4] - '0') * 100 + (c[5] - '0') * 10 + (c[6] - '0');
+		c += 7;
+
+	} else {
+
+		/* handle negatives */
+		bool negative = false;
+		if (c < end && *c == '-') {
+			negative = true;
+			c++;
+		}
+
+		if (c == end || !ISDIGIT(*c))
+			return PARSE_BAD_YEAR;
+
+		while (c < end && ISDIGIT(*c)) {
+			year = year * 10 + (*c - '0');
+			if (year > MAX_YEAR) {
+				*value = negative ? -year : year;
+				return PARSE_YEAR_RANGE;
+			}
+			c++;
+		}
+		if (negative)
+			year = -year;
+
+		/* skip non-digit values */
+		while (c < end && !ISDIGIT(*c))
+			c++;
+
+		while (c < end && ISDIGIT(*c)) {
+			yday = yday * 10 + (*c - '0');
+			if (yday > 366)
+				return PARSE_BAD_DAY;
+			c++;
+		}
+	}
+
+	if (yday < 1 || yday > 365 + ISLEAP(year))
+		return PARSE_BAD_DAY;
+
+	*value = days_from_civil_kernel(kernel, year, 1, 1) + yday - 1;
+	return finish(c, end, strict);
+}
+
+const struct date_format date_formats[] = {
+	{"ymd", parse_ymd},
+	{"yyyymmdd", parse_compact},
+	{"yday", parse_yday},
+	{"dmy", parse_dmy},
+	{"mdy", parse_mdy},
+	{NULL, NULL}
+};
+
+/* read exactly two digits */
+static inline bool two_digits(const char *c, const char *end, int *value)
+{
+	if (end - c < 2 || !ISDIGIT(c[0]) || !ISDIGIT(c[1]))
+		return false;
+	*value = (c[0] - '0') * 10 + (c[1] - '0');
+	return true;
+}
+
+/*
+ * Parse the timestamp in [c, end). The date is scanned as in parse_ymd() and
+ * is followed by any non-digit separator (e.g. "T" or " ") then a time of the
+ * form "hh:mm", "hh:mm:ss" or "hh:mm:ss.fff" (the colons are optional). An
+ * optional UTC offset of "Z", "+hh", "+hhmm" or "+hh:mm" (or "-") may follow.
+ * On success `value` is set to the seconds since the epoch in UTC. If the year
+ * is out of range `value` is set to the offending year.
+ */
+enum parse_status parse_ymd_hms(const char *c, const char *end, bool strict, enum civil_kernel kernel, double *value)
+{
+	int days;
+	enum parse_status status = scan_ymd(&c, end, kernel, &days);
+	if (status != PARSE_OK) {
+		if (status == PARSE_YEAR_RANGE)
+			*value = days;
+		return status;
+	}
+
+	/* skip separator between date and time */
+	while (c < end && !ISDIGIT(*c))
+		c++;
+
+	/* hours and minutes are required */
+	int hour, min, sec = 0;
+	if (!two_digits(c, end, &hour) || hour > 23)
+		return PARSE_BAD_TIME;
+	c += 2;
+	if (c < end && *c == ':')
+		c++;
+	if (!two_digits(c, end, &min) || min > 59)
+		return PARSE_BAD_TIME;
+	c += 2;
+
+	/* seconds are optional */
+	if (c < end && *c == ':')
+		c++;
+	if (c < end && ISDIGIT(*c)) {
+		if (!two_digits(c, end, &sec) || sec > 59)
+			return PARSE_BAD_TIME;
+		c += 2;
+	}
+
+	/* as are fractional seconds */
+	double frac = 0;
+	if (c < end && (*c == '.' || *c == ',')) {
+		c++;
+		if (c == end || !ISDIGIT(*c))
+			return PARSE_BAD_TIME;
+		/* digits beyond nanoseconds are ignored */
+		int digits = 0, ns = 0;
+		while (c < end && ISDIGIT(*c)) {
+			if (digits < 9) {
+				ns = ns * 10 + (*c - '0');
+				digits++;
+			}
+			c++;
+		}
+		for (; digits < 9; digits++)
+			ns *= 10;
+		frac = ns / 1e9;
+	}
+
+	/* and the offset from UTC */
+	int offset = 0;
+	while (c < end && *c == ' ')
+		c++;
+	if (c < end && (*c == 'Z' || *c == 'z')) {
+		c++;
+	} else if (c < end && (*c == '+' || *c == '-')) {
+		int sign = *c == '-' ? -1 : 1;
+		int off_hour, off_min = 0;
+		c++;
+		if (!two_digits(c, end, &off_hour) || off_hour > 23)
+			return PARSE_BAD_TIME;
+		c += 2;
+		if (c < end && *c == ':')
+			c++;
+		if (c < end && ISDIGIT(*c)) {
+			if (!two_digits(c, end, &off_min) || off_min > 59)
+				return PARSE_BAD_TIME;
+			c += 2;
+		}
+		offset = sign * (off_hour * 3600 + off_min * 60);
+	}
+
+	/* skip trailing whitespace */
+	while(c < end && ISSPACE(*c))
+		c++;
+
+	/* if strict we allow nothing at the end */
+	if (strict && c != end)
+		return PARSE_TRAILING;
+
+	*value = (double) days * 86400 + (hour * 3600 + min * 60 + sec - offset) + frac;
+	return PARSE_OK;
+}
@@ -0,0 +1,77 @@
+#ifndef FASTYMD_PARSE_H
+#define FASTYMD_PARSE_H
+
+#include "calendar.h"
+#include "kernel.h"
+
+#include <stdbool.h>
+
+/* From musl. */
+/* More efficient than using the functions for out purposes. */
+/* https://git.musl-libc.org/cgit/musl/tree/src/ctype/isdigit.c */
+/* https://git.musl-libc.org/cgit/musl/tree/src/ctype/isspace.c */
+#define ISDIGIT(c) ((unsigned)(c)-'0' < 10)
+#define ISSPACE(c) ((c) == ' ' || (unsigned)(c)-'\t' < 5)
+
+/* Statuses after PARSE_YEAR_RANGE are all invalid strings (by reason). */
+enum parse_status {
+	PARSE_OK,
+	PARSE_YEAR_RANGE,
+	PARSE_BAD_YEAR,
+	PARSE_BAD_MONTH,
+	PARSE_BAD_DAY,
+	PARSE_TRAILING,
+	PARSE_BAD_TIME
+};
+
+/* status of a (non-missing) year, month and day */
+static inline enum parse_status check_ymd(int year, int month, int day)
+{
+	if (month < 1 || month > 12)
+		return PARSE_BAD_MONTH;
+
+	if (day < 1 || day > days_in_month(year, month))
+		return PARSE_BAD_DAY;
+
+	return PARSE_OK;
+}
+
+/*
+ * Days from a (non-missing) integer code year * 10000 + month * 100 + day,
+ * negated for negative years. The divisions are by constants so compile to
+ * multiply and shift. For PARSE_YEAR_RANGE the year is stored in *value.
+ */
+static inline enum parse_status parse_yyyymmdd_code(int code, enum civil_kernel kernel, int *value)
+{
+	const unsigned u = code < 0 ? -(unsigned) code : (unsigned) code;
+	const unsigned yy = u / 10000;
+	const unsigned mmdd = u - yy * 10000;
+	const int month = (int) (mmdd / 100);
+	const int day = (int) (mmdd - (unsigned) month * 100);
+	const int year = code < 0 ? -(int) yy : (int) yy;
+
+	if (yy > MAX_YEAR) {
+		*value = year;
+		return PARSE_YEAR_RANGE;
+	}
+
+	enum parse_status status = check_ymd(year, month, day);
+	if (status == PARSE_OK)
+		*value = days_from_civil_kernel(kernel, year, month, day);
+	return status;
+}
+
+/* a date parser for one format; see parse_ymd() */
+typedef enum parse_status (*date_parser)(const char *c, const char *end, bool strict, enum civil_kernel kernel, int *value);
+
+/* the selectable formats in order of preference, ending with a NULL name */
+struct date_format {
+	const char *name;
+	date_parser parse;
+};
+extern const struct date_format date_formats[];
+
+enum parse_status parse_ymd(const char *c, const char *end, bool strict, enum civil_kernel kernel, int *value);
+enum parse_status parse_ymd_hms(const char *c, const char *end, bool strict, enum civil_kernel kernel, double *value);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef FASTYMD_POSIXCT_H
+#define FASTYMD_POSIXCT_H
+
+#include <limits.h>
+#include <math.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Local day numbers of POSIXct times. The time zone is described by a table
+ * of UTC offsets (in seconds) where offsets[k] applies from times[k] up to
+ * times[k + 1] and times[0] is -Inf. UTC and fixed offsets have a single
+ * entry so are pure arithmetic. Named zones hold their transitions over the
+ * range of the input and the table is only searched when a time leaves the
+ * current interval, i.e. once per run of nearby times rather than once per
+ * element.
+ */
+struct tz_table {
+	const double *times;
+	const double *offsets;
+	int n;
+};
+
+/* the interval holding t (times[k] <= t < times[k + 1]) */
+static inline int tz_find(const struct tz_table *tz, double t)
+{
+	int lo = 0, hi = tz->n;
+	while (hi - lo > 1) {
+		int mid = lo + (hi - lo) / 2;
+		if (tz->times[mid] <= t)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* *k is the interval of the previous time and is updated as needed */
+static inline int posixct_day(double t, const struct tz_table *tz, int *k)
+{
+	if (ISNAN(t))
+		return NA_INTEGER;
+	if (tz->n > 1 && (t < tz->times[*k] || (*k + 1 < tz->n && t >= tz->times[*k + 1])))
+		*k = tz_find(tz, t);
+	double v = floor((t + tz->offsets[*k]) / 86400);
+	return (v >= INT_MAX + 1. || v <= INT_MIN) ? NA_INTEGER : (int) v;
+}
+
+/* local days for the block [from, from + len) */
+static inline const int *load_posixct_days(const double *pr, R_xlen_t from, R_xlen_t len, int *buf, const struct tz_table *tz)
+{
+	int k = 0;
+	for (R_xlen_t i = 0; i < len; i++)
+		buf[i] = posixct_day(pr[from + i], tz, &k);
+	return buf;
+}
+
+#endif
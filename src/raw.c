@@ -0,0 +1,225 @@
+#include "calendar.h"
+#include "diagnostics.h"
+#include "kernel.h"
+#include "parse.h"
+#include "threads.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/*
+ * Parsing of dates held in raw vectors. Fields are parsed in place with
+ * parse_ymd() using either fixed width records or an offsets vector (as used
+ * by Arrow style string columns) to locate each field. Blank and "NA" fields
+ * (and those with NA offsets) are missing. Failures are handled as for
+ * character input (see note_failure()).
+ */
+
+static void finish(SEXP out, struct diagnostics *diags, int nth, bool warn, bool warn_range, R_xlen_t bad, int bad_year)
+{
+	if (bad < XLENGTH(out))
+		Rf_error("Years must be in the range [%d, %d]. x[%td] is %d.", -MAX_YEAR, MAX_YEAR, bad, bad_year);
+
+	/* diagnostics replace the warnings */
+	if (diags) {
+		diagnostics_set(out, diags, nth);
+	} else {
+		if (warn)
+			Rf_warning("NAs introduced due to invalid date strings.");
+		if (warn_range)
+			Rf_warning("NAs introduced due to years outside the range [%d, %d].", -MAX_YEAR, MAX_YEAR);
+	}
+
+	/* set class to "Date" */
+	Rf_classgets(out, Rf_mkString("Date"));
+}
+
+static void check_flags(SEXP strict, SEXP diagnostics, SEXP range_na)
+{
+	if ((!IS_SCALAR(strict, LGLSXP)) || LOGICAL_RO(strict)[0] == NA_LOGICAL)
+		Rf_error("`strict` must be a bool.");
+	if ((!IS_SCALAR(diagnostics, LGLSXP)) || LOGICAL_RO(diagnostics)[0] == NA_LOGICAL)
+		Rf_error("`diagnostics` must be a bool.");
+	if ((!IS_SCALAR(range_na, LGLSXP)) || LOGICAL_RO(range_na)[0] == NA_LOGICAL)
+		Rf_error("`range_na` must be a bool.");
+}
+
+/* a field that is blank or "NA" (ignoring surrounding whitespace) is missing */
+static inline bool missing_field(const char *from, const char *to)
+{
+	while (from < to && ISSPACE(*from))
+		from++;
+	while (to > from && ISSPACE(to[-1]))
+		to--;
+	return from == to || (to - from == 2 && from[0] == 'N' && from[1] == 'A');
+}
+
+enum field_bounds { BOUNDS_OK, BOUNDS_NA, BOUNDS_INVALID };
+
+/* bounds of field i, which must be increasing whole numbers within the buffer unless NA */
+static inline enum field_bounds field_bounds(const int *ioff, const double *doff, R_xlen_t i, R_xlen_t nbytes, R_xlen_t *from, R_xlen_t *to)
+{
+	double lo, hi;
+	if (ioff) {
+		if (ioff[i] == NA_INTEGER || ioff[i + 1] == NA_INTEGER)
+			return BOUNDS_NA;
+		lo = ioff[i];
+		hi = ioff[i + 1];
+	} else {
+		lo = doff[i];
+		hi = doff[i + 1];
+		if (ISNAN(lo) || ISNAN(hi))
+			return BOUNDS_NA;
+		if (lo != floor(lo) || hi != floor(hi))
+			return BOUNDS_INVALID;
+	}
+	if (lo < 0 || hi < lo || hi > nbytes)
+		return BOUNDS_INVALID;
+	*from = (R_xlen_t) lo;
+	*to = (R_xlen_t) hi;
+	return BOUNDS_OK;
+}
+
+static R_xlen_t as_size(SEXP x, const char *name)
+{
+	if (!(IS_SCALAR(x, INTSXP) || IS_SCALAR(x, REALSXP)))
+		Rf_error("`%s` must be a non-negative whole number.", name);
+	double value = Rf_asReal(x);
+	if (ISNAN(value) || value < 0 || value != floor(value) || value > R_XLEN_T_MAX)
+		Rf_error("`%s` must be a non-negative whole number.", name);
+	return (R_xlen_t) value;
+}
+
+SEXP ymd_raw(SEXP x, SEXP width, SEXP offset, SEXP length, SEXP strict, SEXP diagnostics, SEXP range_na)
+{
+	if (TYPEOF(x) != RAWSXP)
+		Rf_error("Input `x` must be a raw vector.");
+	check_flags(strict, diagnostics, range_na);
+
+	R_xlen_t width_ = as_size(width, "width");
+	R_xlen_t offset_ = as_size(offset, "offset");
+	R_xlen_t length_ = as_size(length, "length");
+	bool strict_ = LOGICAL_RO(strict)[0];
+	bool range_na_ = LOGICAL_RO(range_na)[0];
+
+	R_xlen_t nbytes = XLENGTH(x);
+	if (width_ == 0 || nbytes % width_ != 0)
+		Rf_error("The length of `x` must be a multiple of `width`.");
+	if (offset_ + length_ > width_)
+		Rf_error("Fields must lie within a record (`offset + length <= width`).");
+
+	R_xlen_t size = nbytes / width_;
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, size));
+	int* pout = INTEGER(out);
+	const char *base = (const char *) RAW_RO(x) + offset_;
+
+	int nth = num_threads(size);
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	/* failures are only recorded on request */
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc(nth) : NULL;
+
+	/* errors and warnings are raised once all threads have finished */
+	bool warn = false;
+	bool warn_range = false;
+	R_xlen_t bad = size;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:warn_range) reduction(min:bad)
+	for (R_xlen_t i = 0; i < size; i++) {
+		struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+		const char *from = base + i * width_;
+		if (missing_field(from, from + length_)) {
+			pout[i] = NA_INTEGER;
+			continue;
+		}
+		int value;
+		enum parse_status status = parse_ymd(from, from + length_, strict_, kernel, &value);
+		if (status == PARSE_OK) {
+			pout[i] = value;
+			continue;
+		}
+		pout[i] = NA_INTEGER;
+		note_failure(status, i, diag, range_na_, &warn, &warn_range, &bad);
+	}
+
+	/* the year of the first out of range field is found by parsing it again */
+	int bad_year = 0;
+	if (bad < size)
+		parse_ymd(base + bad * width_, base + bad * width_ + length_, strict_, kernel, &bad_year);
+
+	finish(out, diags, nth, warn, warn_range, bad, bad_year);
+	UNPROTECT(1);
+	return out;
+}
+
+SEXP ymd_raw_offsets(SEXP x, SEXP offsets, SEXP strict, SEXP diagnostics, SEXP range_na)
+{
+	if (TYPEOF(x) != RAWSXP)
+		Rf_error("Input `x` must be a raw vector.");
+	if (TYPEOF(offsets) != INTSXP && TYPEOF(offsets) != REALSXP)
+		Rf_error("`offsets` must be a numeric vector.");
+	check_flags(strict, diagnostics, range_na);
+
+	bool strict_ = LOGICAL_RO(strict)[0];
+	bool range_na_ = LOGICAL_RO(range_na)[0];
+	R_xlen_t noffsets = XLENGTH(offsets);
+	if (noffsets == 0)
+		Rf_error("`offsets` must have length one more than the number of fields.");
+
+	R_xlen_t size = noffsets - 1;
+	R_xlen_t nbytes = XLENGTH(x);
+	const char *base = (const char *) RAW_RO(x);
+	const int *ioff = TYPEOF(offsets) == INTSXP ? INTEGER_RO(offsets) : NULL;
+	const double *doff = TYPEOF(offsets) == REALSXP ? REAL_RO(offsets) : NULL;
+
+	/* offsets are checked up front so no field is read from a bad range */
+	for (R_xlen_t i = 0; i < size; i++) {
+		R_xlen_t from, to;
+		if (field_bounds(ioff, doff, i, nbytes, &from, &to) == BOUNDS_INVALID)
+			Rf_error("Invalid offsets for field %td. Offsets must be increasing whole numbers no greater than the length of `x`.", i + 1);
+	}
+
+	SEXP out = PROTECT(Rf_allocVector(INTSXP, size));
+	int* pout = INTEGER(out);
+
+	int nth = num_threads(size);
+	const enum civil_kernel kernel = civil_kernel_option();
+
+	/* failures are only recorded on request */
+	struct diagnostics *diags = LOGICAL_RO(diagnostics)[0] ? diagnostics_alloc(nth) : NULL;
+
+	/* errors and warnings are raised once all threads have finished */
+	bool warn = false;
+	bool warn_range = false;
+	R_xlen_t bad = size;
+	#pragma omp parallel for num_threads(nth) schedule(static) reduction(||:warn) reduction(||:warn_range) reduction(min:bad)
+	for (R_xlen_t i = 0; i < size; i++) {
+		struct diagnostics *diag = diags ? &diags[thread_num()] : NULL;
+		R_xlen_t from, to;
+		if (field_bounds(ioff, doff, i, nbytes, &from, &to) != BOUNDS_OK || missing_field(base + from, base + to)) {
+			pout[i] = NA_INTEGER;
+			continue;
+		}
+		int value;
+		enum parse_status status = parse_ymd(base + from, base + to, strict_, kernel, &value);
+		if (status == PARSE_OK) {
+			pout[i] = value;
+			continue;
+		}
+		pout[i] = NA_INTEGER;
+		note_failure(status, i, diag, range_na_, &warn, &warn_range, &bad);
+	}
+
+	/* the year of the first out of range field is found by parsing it again */
+	int bad_year = 0;
+	R_xlen_t from, to;
+	if (bad < size && field_bounds(ioff, doff, bad, nbytes, &from, &to) == BOUNDS_OK)
+		parse_ymd(base + from, base + to, strict_, kernel, &bad_year);
+
+	finish(out, diags, nth, warn, warn_range, bad, bad_year);
+	UNPROTECT(1);
+	return out;
+}
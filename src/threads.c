@@ -0,0 +1,47 @@
+#include "threads.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/*
+ * Largest number of threads to use. This is taken from the `fastymd.threads`
+ * option (default 1) and capped at the number of available processors.
+ */
+int thread_limit(void)
+{
+#ifdef _OPENMP
+	SEXP opt = Rf_GetOption1(Rf_install("fastymd.threads"));
+	if (Rf_isNull(opt))
+		return 1;
+
+	int nth = Rf_asInteger(opt);
+	if (nth == NA_INTEGER || nth < 1)
+		Rf_error("Option `fastymd.threads` must be a positive integer.");
+
+	int max = omp_get_num_procs();
+	return nth > max ? max : nth;
+#else
+	return 1;
+#endif
+}
+
+/*
+ * Number of threads to use for a loop over `n` elements, at most
+ * thread_limit(). Small inputs are not worth the cost of spinning up the
+ * thread team so these always run serially.
+ */
+int num_threads(R_xlen_t n)
+{
+	return n < MIN_PARALLEL_SIZE ? 1 : thread_limit();
+}
+
+/* Index of the calling thread within the current team. */
+int thread_num(void)
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
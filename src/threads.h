@@ -0,0 +1,20 @@
+#ifndef FASTYMD_THREADS_H
+#define FASTYMD_THREADS_H
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+/* Inputs shorter than this are always processed on a single thread. */
+#define MIN_PARALLEL_SIZE 100000
+
+int thread_limit(void);
+
+/*
+ * The thread count for n elements. Without OpenMP the result is only read by
+ * the (ignored) pragmas so callers mark it as used with a cast to void.
+ */
+int num_threads(R_xlen_t n);
+int thread_num(void);
+
+#endif